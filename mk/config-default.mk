@@ -1,7 +1,5 @@
 # Supported: GCC, CLANG, ICX
 TOOLCHAIN ?= CLANG
-# Supported CRS, SCS, CCRS
-MTX_FMT ?= CRS
 ENABLE_MPI ?= true
 ENABLE_OPENMP ?= false
 FLOAT_TYPE ?= DP # SP for float, DP for double
@@ -14,13 +12,14 @@ OPTIONS +=  -DOMP_SCHEDULE=static
 #OPTIONS +=  -DVERBOSE_AFFINITY
 #OPTIONS +=  -DVERBOSE_DATASIZE
 #OPTIONS +=  -DVERBOSE_TIMER
+#OPTIONS +=  -DPERF_EVENTS
+#OPTIONS +=  -DTHREAD_TIMER
 
 
 ################################################################
 # DO NOT EDIT BELOW !!!
 ################################################################
 DEFINES =
-DEFINES += -D$(MTX_FMT)
 
 ifeq ($(strip $(FLOAT_TYPE)),SP)
     DEFINES += -DPRECISION=1
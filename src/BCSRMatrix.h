@@ -0,0 +1,28 @@
+/* Copyright (C) NHR@FAU, University Erlangen-Nuremberg.
+ * All rights reserved. This file is part of SparseBench.
+ * Use of this source code is governed by a MIT style
+ * license that can be found in the LICENSE file. */
+#ifndef __BCSRMATRIX_H_
+#define __BCSRMATRIX_H_
+#include "util.h"
+
+// Largest block size tried by the conversion
+#define BCSR_MAXB 4
+
+// Dense b by b blocks in row major order aligned to the global rows. The first
+// block row starts off rows before the first local row, a block starts at column
+// colInd. Blocks that would reach before the first or behind the last column of
+// x are shifted into it.
+typedef struct {
+  int b; // block size
+  int off; // global row of the first local row modulo b
+  CG_UINT nbr; // number of block rows, the first and last may be partial
+  CG_UINT nBlocks; // number of stored blocks
+  CG_UINT *rowPtr; // block row Pointer
+  CG_UINT *colInd; // first column of every block
+  CG_FLOAT *val; // b * b entries per block including explicit zeros
+} BCSRMatrix;
+
+extern void bcsrRowLengths(BCSRMatrix *sm, CG_UINT nr, CG_FLOAT *len);
+
+#endif // __BCSRMATRIX_H_
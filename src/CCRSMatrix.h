@@ -12,11 +12,8 @@ typedef struct {
 } mEntry;
 
 typedef struct {
-  CG_UINT nr, nc, nnz; // number of rows, columns and non zeros
-  CG_UINT totalNr, totalNnz; // number of total rows and non zeros
-  CG_UINT startRow, stopRow; // range of rows owned by current rank
   CG_UINT *rowPtr; // row Pointer
   mEntry *entries;
-} Matrix;
+} CCRSMatrix;
 
 #endif // __CCRSMATRIX_H_
@@ -0,0 +1,25 @@
+/* Copyright (C) NHR@FAU, University Erlangen-Nuremberg.
+ * All rights reserved. This file is part of SparseBench.
+ * Use of this source code is governed by a MIT style
+ * license that can be found in the LICENSE file. */
+#ifndef __CRS16MATRIX_H_
+#define __CRS16MATRIX_H_
+#include <stdint.h>
+
+#include "util.h"
+
+// Marks a row in base whose columns do not fit into 16 bit offsets
+#define CRS16_WIDE CG_UINT_MAX
+
+typedef struct {
+  CG_UINT *rowPtr; // row Pointer
+  CG_UINT *base; // smallest column of the row, CRS16_WIDE for wide rows
+  uint16_t *offset; // column minus base, unused for wide rows
+  CG_FLOAT *val; // matrix entries
+  CG_UINT nWide; // number of rows with full column indices
+  CG_UINT *wideRow; // row of every wide row
+  CG_UINT *wideRowPtr; // row pointer into wideColInd
+  CG_UINT *wideColInd; // colum indices of the wide rows
+} CRS16Matrix;
+
+#endif // __CRS16MATRIX_H_
@@ -0,0 +1,15 @@
+/* Copyright (C) NHR@FAU, University Erlangen-Nuremberg.
+ * All rights reserved. This file is part of SparseBench.
+ * Use of this source code is governed by a MIT style
+ * license that can be found in the LICENSE file. */
+#ifndef __CRSFMATRIX_H_
+#define __CRSFMATRIX_H_
+#include "util.h"
+
+typedef struct {
+  CG_UINT *rowPtr; // row Pointer
+  CG_UINT *colInd; // colum Indices
+  float *val; // matrix entries rounded to single precision
+} CRSFMatrix;
+
+#endif // __CRSFMATRIX_H_
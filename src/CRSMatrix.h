@@ -7,12 +7,9 @@
 #include "util.h"
 
 typedef struct {
-  CG_UINT nr, nc, nnz; // number of rows, columns and non zeros
-  CG_UINT totalNr, totalNnz; // number of total rows and non zeros
-  CG_UINT startRow, stopRow; // range of rows owned by current rank
   CG_UINT *rowPtr; // row Pointer
   CG_UINT *colInd; // colum Indices
   CG_FLOAT *val; // matrix entries
-} Matrix;
+} CRSMatrix;
 
 #endif // __CRSMATRIX_H_
@@ -11,9 +11,6 @@
 #include "util.h"
 
 typedef struct {
-  CG_UINT nr, nc, nnz; // number of rows, columns and non zeros
-  CG_UINT totalNr, totalNnz; // number of total rows and non zeros
-  CG_UINT startRow, stopRow; // range of rows owned by current rank
   CG_UINT *colInd; // colum Indices
   CG_FLOAT *val; // matrix entries
   CG_UINT C, sigma; // chunk height and sorting scope
@@ -24,11 +21,13 @@ typedef struct {
   CG_UINT *chunkLens; // lengths of chunks
   CG_UINT *oldToNewPerm; // permutations for rows (and cols)
   CG_UINT *newToOldPerm; // inverse permutations for rows (and cols)
-} Matrix;
+} SCSMatrix;
 
 typedef struct {
   int index;
   int count;
 } SellCSigmaPair;
 
+extern void scsRowLengths(SCSMatrix *sm, CG_UINT nr, CG_FLOAT *len);
+
 #endif // __SCSMATRIX_H_
@@ -0,0 +1,26 @@
+/* Copyright (C) NHR@FAU, University Erlangen-Nuremberg.
+ * All rights reserved. This file is part of SparseBench.
+ * Use of this source code is governed by a MIT style
+ * license that can be found in the LICENSE file. */
+#ifndef __SYMMATRIX_H_
+#define __SYMMATRIX_H_
+#include "util.h"
+
+// Upper triangle including the diagonal of the rank local block, the entries in
+// halo columns are stored completely. The rows are split into nParts static
+// partitions, the transposed contributions of a partition to rows behind it are
+// collected in its own range of partial and added after all partitions are done.
+typedef struct {
+  CG_UINT *rowPtr; // row Pointer
+  CG_UINT *colInd; // colum Indices
+  CG_FLOAT *val; // matrix entries
+  int nParts; // number of row partitions
+  CG_UINT *partPtr; // first row of every partition
+  CG_UINT *reach; // end of the rows a partition writes to
+  CG_UINT *partialPtr; // offset of every partition into partial
+  CG_FLOAT *partial; // transposed contributions behind the own rows
+} SYMMatrix;
+
+extern void symRowLengths(SYMMatrix *sm, CG_UINT nr, CG_FLOAT *len);
+
+#endif // __SYMMATRIX_H_
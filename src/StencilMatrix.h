@@ -0,0 +1,28 @@
+/* Copyright (C) NHR@FAU, University Erlangen-Nuremberg.
+ * All rights reserved. This file is part of SparseBench.
+ * Use of this source code is governed by a MIT style
+ * license that can be found in the LICENSE file. */
+#ifndef __STENCILMATRIX_H_
+#define __STENCILMATRIX_H_
+#include <stdbool.h>
+
+#include "parameter.h"
+#include "util.h"
+
+// Matrix free operator of the generated 27 or 7 point stencil. Every rank owns
+// nz planes of nx by ny points, the halo are the neighbouring planes of the
+// ranks below and above.
+typedef struct {
+  int nx, ny, nz; // local grid
+  int points; // 27 or 7
+  bool haloBelow, haloAbove; // rank has a plane below or above
+  CG_UINT *below; // local column of every point of the halo plane below
+  CG_UINT *above; // local column of every point of the halo plane above
+  CG_FLOAT *xBelow; // halo plane below gathered from x for every spMVM
+  CG_FLOAT *xAbove; // halo plane above gathered from x for every spMVM
+} StencilMatrix;
+
+extern bool stencilInit(StencilMatrix *sm, Parameter *p);
+extern CG_UINT stencilRowLength(StencilMatrix *sm, CG_UINT row);
+
+#endif // __STENCILMATRIX_H_
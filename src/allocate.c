@@ -4,11 +4,17 @@
  * license that can be found in the LICENSE file. */
 #include <errno.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "allocate.h"
 
+// Allocations happen outside of parallel regions only
+static MemoryPhaseType Phase = MEM_SETUP;
+static MemoryStats Stats[NUMMEMPHASES];
+
 void *allocate(size_t alignment, size_t bytesize)
 {
   int errorCode;
@@ -32,5 +38,105 @@ void *allocate(size_t alignment, size_t bytesize)
     exit(EXIT_FAILURE);
   }
 
+  Stats[Phase].allocated += bytesize;
+  Stats[Phase].allocations++;
+
   return ptr;
 }
+
+/**
+ * @brief Resize an allocation made with allocate.
+ *
+ * The content up to the smaller of both sizes is kept. Shrinking usually
+ * happens in place, if realloc moves the block to a misaligned address it is
+ * copied once more into an aligned one.
+ *
+ * @param ptr Allocation to resize
+ * @param alignment Alignment of the allocation
+ * @param newBytesize New size in bytes
+ * @param oldBytesize Current size in bytes
+ * @return Pointer to the resized allocation
+ */
+void *reallocate(void *ptr, size_t alignment, size_t newBytesize, size_t oldBytesize)
+{
+  void *newPtr = realloc(ptr, newBytesize);
+
+  if (newPtr == NULL) {
+    fprintf(stderr, "Error: Insufficient memory to fulfill the request\n");
+    exit(EXIT_FAILURE);
+  }
+
+  if ((uintptr_t)newPtr % alignment != 0) {
+    void *aligned = allocate(alignment, newBytesize);
+
+    memcpy(aligned,
+        newPtr,
+        newBytesize < oldBytesize ? newBytesize : oldBytesize);
+    free(newPtr);
+    return aligned;
+  }
+
+  if (newBytesize > oldBytesize) {
+    Stats[Phase].allocated += newBytesize - oldBytesize;
+  }
+  return newPtr;
+}
+
+// Current and peak resident set size in bytes from /proc/self/status, both 0
+// if it is not available
+static void readResident(size_t *resident, size_t *peak)
+{
+  char line[256];
+  FILE *fp = fopen("/proc/self/status", "r");
+
+  *resident = 0;
+  *peak     = 0;
+  if (fp == NULL) {
+    return;
+  }
+
+  while (fgets(line, sizeof(line), fp) != NULL) {
+    unsigned long kB;
+
+    if (sscanf(line, "VmRSS: %lu kB", &kB) == 1) {
+      *resident = 1024 * (size_t)kB;
+    } else if (sscanf(line, "VmHWM: %lu kB", &kB) == 1) {
+      *peak = 1024 * (size_t)kB;
+    }
+  }
+  fclose(fp);
+}
+
+// Reset the peak resident set size to the current one. Where this is not
+// supported the peak of a phase is the peak since the program start.
+static void resetPeakResident(void)
+{
+  FILE *fp = fopen("/proc/self/clear_refs", "w");
+
+  if (fp != NULL) {
+    fputs("5", fp);
+    fclose(fp);
+  }
+}
+
+/**
+ * @brief Start a new memory phase.
+ *
+ * Ends the current phase and records its peak and final resident set size.
+ * All following allocations are accounted to the new phase.
+ *
+ * @param phase The starting phase
+ */
+void allocatePhase(MemoryPhaseType phase)
+{
+  readResident(&Stats[Phase].resident, &Stats[Phase].peakResident);
+  resetPeakResident();
+  Phase = phase;
+}
+
+// Statistics of all phases, the current phase is sampled now
+void allocateStats(MemoryStats *stats)
+{
+  readResident(&Stats[Phase].resident, &Stats[Phase].peakResident);
+  memcpy(stats, Stats, sizeof(Stats));
+}
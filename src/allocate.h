@@ -6,6 +6,28 @@
 #define __ALLOCATE_H_
 #include <stdlib.h>
 
+// Setup phases, every allocation is accounted to the phase it happens in
+typedef enum {
+  MEM_SETUP = 0,
+  MEM_READ,
+  MEM_DISTRIBUTE,
+  MEM_LOCALIZE,
+  MEM_CONVERT,
+  MEM_SOLVE,
+  NUMMEMPHASES
+} MemoryPhaseType;
+
+typedef struct {
+  size_t allocated; // bytes requested with allocate
+  size_t allocations; // number of allocate calls
+  size_t peakResident; // peak resident set size in bytes, 0 if unknown
+  size_t resident; // resident set size in bytes at the end of the phase
+} MemoryStats;
+
 extern void *allocate(size_t alignment, size_t bytesize);
+extern void *reallocate(
+    void *ptr, size_t alignment, size_t newBytesize, size_t oldBytesize);
+extern void allocatePhase(MemoryPhaseType phase);
+extern void allocateStats(MemoryStats *stats);
 
 #endif
@@ -38,7 +38,7 @@ void bstFree(Bstree *b)
   return;
 }
 
-bool bstExists(Bstree *b, CG_UINT key)
+bool bstExists(Bstree *b, CG_GINT key)
 {
   Node *tmp;
 
@@ -56,7 +56,7 @@ bool bstExists(Bstree *b, CG_UINT key)
   }
 }
 
-CG_UINT bstFind(Bstree *b, CG_UINT key)
+CG_UINT bstFind(Bstree *b, CG_GINT key)
 {
   Node *tmp;
 
@@ -88,7 +88,7 @@ void bstWalk(Bstree *b)
   rWalk(b->root);
 }
 
-void bstInsert(Bstree *b, CG_UINT key, CG_UINT value)
+void bstInsert(Bstree *b, CG_GINT key, CG_UINT value)
 {
   Node *bs, *tmp;
 
@@ -8,7 +8,7 @@
 #include "stdbool.h"
 #include "util.h"
 typedef struct node {
-  CG_UINT key;
+  CG_GINT key;
   CG_UINT value;
   struct node *left;
   struct node *right;
@@ -20,8 +20,8 @@ typedef struct {
 
 extern Bstree *bstNew(void);
 extern void bstFree(Bstree *);
-extern CG_UINT bstFind(Bstree *, CG_UINT key);
-extern bool bstExists(Bstree *, CG_UINT key);
-extern void bstInsert(Bstree *, CG_UINT key, CG_UINT value);
+extern CG_UINT bstFind(Bstree *, CG_GINT key);
+extern bool bstExists(Bstree *, CG_GINT key);
+extern void bstInsert(Bstree *, CG_GINT key, CG_UINT value);
 extern void bstWalk(Bstree *leaf);
 #endif
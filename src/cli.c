@@ -13,36 +13,37 @@
 #include <unistd.h>
 
 #include "cli.h"
+#include "matrix.h"
 #include "matrixBinfile.h"
+#include "mmConvert.h"
 #include "parameter.h"
+#include "partition.h"
+#include "reorder.h"
 
 int BenchType = CG;
 
-#ifdef _MPI
-static void writeBinMatrix(CommType *c, char *filename)
+static void writeBinMatrix(CommType *c, Parameter *p, char *filename)
 {
-  MMMatrix mm;
-  MMMatrix mmLocal;
-  GMatrix m;
   if (commIsMaster(c)) {
-    MMMatrixRead(&mm, filename);
+    mmConvertToBin(
+        filename, changeFileEnding(filename, ".bmx"), (size_t)p->memlimit * 1024 * 1024);
+    fflush(stdout);
   }
-  commDistributeMatrix(c, &mm, &mmLocal);
-  matrixConvertfromMM(&mmLocal, &m);
-  matrixBinWrite(&m, c, changeFileEnding(filename, ".bmx"));
+  commBarrier();
 }
-#endif
 
 void parseArguments(CommType *comm, Parameter *param, int argc, char **argv)
 {
-  char *cvalue = NULL;
+  char *cvalue        = NULL;
+  char *convertFile   = NULL;
+  const char *options = "hc:t:f:F:m:k:d:r:j:T:H:o:la:b:s:w:M:x:y:z:i:e:";
   int index;
   bool stop = false;
   int c;
 
   opterr = 0;
 
-  while ((c = getopt(argc, argv, "hc:t:f:m:x:y:z:i:e:")) != -1) {
+  while ((c = getopt(argc, argv, options)) != -1) {
     switch (c) {
     case 'h':
       if (commIsMaster(comm)) {
@@ -51,19 +52,60 @@ void parseArguments(CommType *comm, Parameter *param, int argc, char **argv)
       commAbort(comm, "Finish write matrix");
       break;
     case 'c':
-#ifdef _MPI
-      writeBinMatrix(comm, optarg);
-      commAbort(comm, "Finish write matrix");
-#else
-      printf("Binary matrix files are only supported with MPI!\n");
-      exit(EXIT_SUCCESS);
-#endif
+      // Convert after all options are parsed to honor the memory budget
+      convertFile = optarg;
+      break;
+    case 'M':
+      param->memlimit = (int)strtol(optarg, NULL, INT_BASE);
+      break;
     case 'f':
       readParameter(param, optarg);
       break;
+    case 'F':
+      matrixFormat(optarg);
+      param->format = optarg;
+      break;
     case 'm':
       param->filename = optarg;
       break;
+    case 'k':
+      param->cachedir = optarg;
+      break;
+    case 'd':
+      partitionType(optarg);
+      param->distribution = optarg;
+      break;
+    case 'r':
+      reorderType(optarg);
+      param->reorder = optarg;
+      break;
+    case 'j':
+      param->json = optarg;
+      break;
+    case 'T':
+      param->trace = optarg;
+      break;
+    case 'H':
+      param->commcsv = optarg;
+      break;
+    case 'o':
+      param->tunefile = optarg;
+      break;
+    case 'l':
+      param->lossy = 1;
+      break;
+    case 'a':
+      param->xreuse = strtod(optarg, NULL);
+      break;
+    case 'b':
+      param->membw = strtod(optarg, NULL);
+      break;
+    case 's':
+      param->stream = (int)strtol(optarg, NULL, INT_BASE);
+      break;
+    case 'w':
+      param->warmup = (int)strtol(optarg, NULL, INT_BASE);
+      break;
     case 't':
       if (strcmp(optarg, "cg") == 0) {
         BenchType = CG;
@@ -73,6 +115,8 @@ void parseArguments(CommType *comm, Parameter *param, int argc, char **argv)
         BenchType = GMRES;
       } else if (strcmp(optarg, "cheb") == 0) {
         BenchType = CHEBFD;
+      } else if (strcmp(optarg, "tune") == 0) {
+        BenchType = TUNE;
       } else {
         printf("Unknown solver type %s\n", optarg);
         exit(EXIT_FAILURE);
@@ -107,6 +151,11 @@ void parseArguments(CommType *comm, Parameter *param, int argc, char **argv)
     }
   }
 
+  if (convertFile != NULL) {
+    writeBinMatrix(comm, param, convertFile);
+    commAbort(comm, "Finish write matrix");
+  }
+
   for (index = optind; index < argc; index++) {
     printf("Non-option argument %s\n", argv[index]);
   }
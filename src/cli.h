@@ -11,7 +11,7 @@
 #include "comm.h"
 #include "parameter.h"
 
-typedef enum { CG = 0, SPMV, GMRES, CHEBFD, NUMTYPES } BenchEnumType;
+typedef enum { CG = 0, SPMV, GMRES, CHEBFD, TUNE, NUMTYPES } BenchEnumType;
 extern int BenchType;
 
 #define HELPTEXT                                                                         \
@@ -19,10 +19,24 @@ extern int BenchType;
   "Options:\n"                                                                           \
   "  -h         Show this help text\n"                                                   \
   "  -c <file name>   Convert MM matrix to binary matrix file.\n"                        \
+  "  -M <int>   Memory budget in MB for converting with -c. Default 1024.\n"             \
   "  -f <parameter file>   Load options from a parameter file\n"                         \
+  "  -F <format>   Matrix format: CRS, SCS, CCRS, CRS16, CRSF, SYM, BCSR or STENCIL\n"   \
+  "                (generated matrices only). Default CRS.\n"                            \
   "  -m <MM matrix>   Load a matrix market file\n"                                       \
-  "  -t <bench type>   Benchmark type, can be cg, spmv, or gmres. Default "              \
+  "  -k <directory>   Cache localized and converted matrices in directory.\n"            \
+  "  -d <type>  Row distribution: rows, nnz, cost or graph. Default rows.\n"             \
+  "  -r <type>  Ordering of the rank local rows: none or rcm. Default none.\n"           \
+  "  -j <file name>   Write results in JSON format to file.\n"                           \
+  "  -T <file name>   Write event timeline in Chrome trace format to file.\n"            \
+  "  -H <file name>   Write halo communication matrix in CSV format to file.\n"          \
+  "  -a <float>   Loads of x per matrix element in the spMVM traffic model.\n"           \
+  "  -b <float>   Measured memory bandwidth in GB/s to compare kernels against.\n"       \
+  "  -s <int>   Measure memory bandwidth with arrays of given MB per rank.\n"            \
+  "  -t <bench type>   Benchmark type, can be cg, spmv, gmres or tune. Default "         \
   "cg.\n"                                                                                \
+  "  -o <file name>   Write the format found with -t tune to a parameter file.\n"        \
+  "  -l         Let -t tune try CRSF with single precision matrix values.\n"             \
   "  -x <int>   Size in x for generated matrix, ignored if MM file is "                  \
   "loaded. Default 100.\n"                                                               \
   "  -y <int>   Size in y for generated matrix, ignored if MM file is "                  \
@@ -30,6 +44,7 @@ extern int BenchType;
   "  -z <int>   Size in z for generated matrix, ignored if MM file is "                  \
   "loaded. Default 100.\n"                                                               \
   "  -i <int>   Number of solver iterations. Default 150.\n"                             \
+  "  -w <int>   Number of untimed warmup iterations. Default 2.\n"                       \
   "  -e <float>  Convergence criteria epsilon. Default 0.0.\n"
 
 extern void parseArguments(CommType *, Parameter *, int, char **);
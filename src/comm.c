@@ -26,15 +26,78 @@
 #include "allocate.h"
 #include "bstree.h"
 #include "comm.h"
+#include "profiler.h"
+#include "timing.h"
 
 #define MPI_TAG_EXCHANGE 100
+#define MPI_TAG_DISTRIBUTE 101
+#define PATTERN_PRINT_RANKS 16
+#define PATTERN_BINS 8
+
+// Profiler regions of the MPI calls, nested into the regions of the callers
+static int RegionHalo      = NOREGION;
+static int RegionReduction = NOREGION;
 
 #ifdef _MPI
 #include <mpi.h>
 
-static int sizeOfRank(int rank, int size, int N)
+/**
+ * @brief Send a message of arbitrary length as a sequence of int sized chunks.
+ *
+ * @param buf Send buffer
+ * @param count Number of elements of type in buf
+ * @param type MPI datatype of the elements
+ * @param dest Destination rank
+ * @param tag Message tag
+ * @return MPI_SUCCESS or the error code of the first failing send
+ */
+int commSendLarge(const void *buf, size_t count, MPI_Datatype type, int dest, int tag)
 {
-  return (N / size) + ((N % size > rank) ? 1 : 0);
+  const char *cursor = (const char *)buf;
+  MPI_Aint lb, extent;
+  MPI_Type_get_extent(type, &lb, &extent);
+
+  while (count > 0) {
+    int n      = (int)MIN(count, (size_t)MPI_CHUNK_COUNT);
+    int result = MPI_Send(cursor, n, type, dest, tag, MPI_COMM_WORLD);
+    if (result != MPI_SUCCESS) {
+      return result;
+    }
+    cursor += (size_t)n * extent;
+    count -= n;
+  }
+
+  return MPI_SUCCESS;
+}
+
+/**
+ * @brief Receive a message sent with commSendLarge.
+ *
+ * @param buf Receive buffer
+ * @param count Number of elements of type to receive
+ * @param type MPI datatype of the elements
+ * @param source Source rank
+ * @param tag Message tag
+ * @return MPI_SUCCESS or the error code of the first failing receive
+ */
+int commRecvLarge(void *buf, size_t count, MPI_Datatype type, int source, int tag)
+{
+  char *cursor = (char *)buf;
+  MPI_Aint lb, extent;
+  MPI_Type_get_extent(type, &lb, &extent);
+
+  while (count > 0) {
+    int n      = (int)MIN(count, (size_t)MPI_CHUNK_COUNT);
+    int result = MPI_Recv(
+        cursor, n, type, source, tag, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+    if (result != MPI_SUCCESS) {
+      return result;
+    }
+    cursor += (size_t)n * extent;
+    count -= n;
+  }
+
+  return MPI_SUCCESS;
 }
 
 /**
@@ -44,7 +107,10 @@ static int sizeOfRank(int rank, int size, int N)
  * source rank are assigned consecutive indices in the local extended RHS vector. This
  * ordering enables efficient MPI communication by ensuring that each rank's data forms
  * a contiguous block in memory, which aligns with MPI_Neighbor_alltoallv requirements.
+ * MPI_Neighbor_alltoallv places the blocks in the order of c->sources, which MPI may
+ * choose differently from the order in which owning ranks appear in the matrix.
  *
+ * @param c Communication structure after retrieveTopology
  * @param numRows Number of local rows owned by this rank
  * @param extCount Total number of external elements
  * @param[out] extLocalIndex Maps from original external index to new local RHS index
@@ -53,42 +119,38 @@ static int sizeOfRank(int rank, int size, int N)
  *                              On output: owning rank for each external (reordered)
  *
  * Algorithm:
- * 1. For each unique owning rank encountered in extOwningRank (in order):
- *    a. Assign the next consecutive local index (starting from numRows)
- *    b. Search remaining externals for same owner and assign consecutive indices
- * 2. Update extOwningRank array to reflect the new ordering
+ * 1. Compute the offset of each source block from c->sources and c->recvCounts
+ * 2. Assign each external the next index of its owner's block, which keeps the
+ *    original order within a block
+ * 3. Update extOwningRank array to reflect the new ordering
  *
  */
-static void reorderExternals(
-    const int numRows, const int extCount, int *extLocalIndex, int *extOwningRank)
+static void reorderExternals(CommType *c,
+    const int numRows,
+    const int extCount,
+    int *extLocalIndex,
+    int *extOwningRank)
 {
   int *newExtOwningRank = (int *)allocate(ARRAY_ALIGNMENT, extCount * sizeof(int));
+  int *blockOffset      = (int *)allocate(ARRAY_ALIGNMENT, c->size * sizeof(int));
+  int cursor            = 0;
 
-  for (int i = 0; i < extCount; i++) {
-    extLocalIndex[i] = -1;
+  for (int i = 0; i < c->indegree; i++) {
+    blockOffset[c->sources[i]] = cursor;
+    cursor += c->recvCounts[i];
   }
 
-  int count = numRows;
-  int index = 0;
-
   for (int i = 0; i < extCount; i++) {
-    if (extLocalIndex[i] == -1) {
-      extLocalIndex[i]          = count++;
-      newExtOwningRank[index++] = extOwningRank[i];
-
-      for (int j = i + 1; j < extCount; j++) {
-        if (extOwningRank[j] == extOwningRank[i]) {
-          extLocalIndex[j]          = count++;
-          newExtOwningRank[index++] = extOwningRank[j];
-        }
-      }
-    }
+    int index               = blockOffset[extOwningRank[i]]++;
+    extLocalIndex[i]        = numRows + index;
+    newExtOwningRank[index] = extOwningRank[i];
   }
 
   for (int i = 0; i < extCount; i++) {
     extOwningRank[i] = newExtOwningRank[i];
   }
 
+  free(blockOffset);
   free(newExtOwningRank);
 }
 
@@ -114,12 +176,12 @@ static void localizeMatrix(GMatrix *A, Bstree *extLookup, const int *extLocalInd
   CG_UINT *rowPtr  = A->rowPtr;
   Entry *entries   = A->entries;
   CG_UINT numRows  = A->nr;
-  CG_UINT startRow = A->startRow;
-  CG_UINT stopRow  = A->stopRow;
+  CG_GINT startRow = A->startRow;
+  CG_GINT stopRow  = A->stopRow;
 
-  for (int i = 0; i < numRows; i++) {
-    for (int j = (int)rowPtr[i]; j < rowPtr[i + 1]; j++) {
-      CG_UINT curIndex = entries[j].col;
+  for (CG_UINT i = 0; i < numRows; i++) {
+    for (CG_UINT j = rowPtr[i]; j < rowPtr[i + 1]; j++) {
+      CG_GINT curIndex = entries[j].col;
 
       if (startRow <= curIndex && curIndex <= stopRow) {
         entries[j].col -= startRow;
@@ -148,12 +210,13 @@ static void localizeMatrix(GMatrix *A, Bstree *extLookup, const int *extLocalInd
  * 3. Send our extLocalToGlobalReordered array to all source ranks (these are the global
  *    indices we need from them)
  * 4. Wait for receives to complete
- * 5. Convert received global indices to local indices by subtracting startRow
+ * 5. Convert received 64-bit global indices to local indices by subtracting startRow
  * 
  * Result: c->elementsToSend[totalSendCount] contains local row indices to pack for sending,
  * organized by destination rank using c->sdispls and c->sendCounts
  */
-static void buildElementsToSend(CommType *c, int startRow, int *extLocalToGlobalReordered)
+static void buildElementsToSend(
+    CommType *c, CG_GINT startRow, CG_GINT *extLocalToGlobalReordered)
 {
   c->totalSendCount = 0;
   for (int i = 0; i < c->outdegree; i++) {
@@ -165,14 +228,17 @@ static void buildElementsToSend(CommType *c, int startRow, int *extLocalToGlobal
   MPI_Request request[c->outdegree];
   c->elementsToSend   = (int *)allocate(ARRAY_ALIGNMENT, c->totalSendCount * sizeof(int));
   int *elementsToSend = c->elementsToSend;
+  // Requested global indices, converted to local indices after the exchange
+  CG_GINT *globalIndices =
+      (CG_GINT *)allocate(ARRAY_ALIGNMENT, c->totalSendCount * sizeof(CG_GINT));
 
-  int j               = 0;
+  int j                  = 0;
 
   for (int i = 0; i < c->outdegree; i++) {
     c->sdispls[i] = j;
-    MPI_Irecv(elementsToSend + j,
+    MPI_Irecv(globalIndices + j,
         c->sendCounts[i],
-        MPI_INT,
+        MPI_GINT_TYPE,
         c->destinations[i],
         MPI_TAG_EXCHANGE,
         MPI_COMM_WORLD,
@@ -187,7 +253,7 @@ static void buildElementsToSend(CommType *c, int startRow, int *extLocalToGlobal
     c->rdispls[i] = j;
     MPI_Send(extLocalToGlobalReordered + j,
         c->recvCounts[i],
-        MPI_INT,
+        MPI_GINT_TYPE,
         c->sources[i],
         MPI_TAG_EXCHANGE,
         MPI_COMM_WORLD);
@@ -198,9 +264,11 @@ static void buildElementsToSend(CommType *c, int startRow, int *extLocalToGlobal
   MPI_Waitall(c->outdegree, request, MPI_STATUSES_IGNORE);
 
   for (int i = 0; i < c->totalSendCount; i++) {
-    elementsToSend[i] -= startRow;
+    elementsToSend[i] = (int)(globalIndices[i] - startRow);
   }
 
+  free(globalIndices);
+
 #ifdef VERBOSE
   for (int i = 0; i < c->size; i++) {
     FPRINTF(c->logFile, "Rank %d: number of elements %d\n", c->rank, c->totalSendCount);
@@ -215,34 +283,16 @@ static void buildElementsToSend(CommType *c, int startRow, int *extLocalToGlobal
 }
 #endif //MPI
 
-static void scanMM(
-    MMMatrix *m, int startRow, int stopRow, int *entryCount, int *entryOffset)
-{
-  MMEntry *e = m->entries;
-  int in     = 0;
-
-  for (size_t i = 0; i < m->count; i++) {
-    if (e[i].row == startRow && in == 0) {
-      *entryOffset = (int)i;
-      in           = 1;
-    }
-    if (e[i].row == (stopRow + 1)) {
-      *entryCount = (int)(i - *entryOffset);
-      break;
-    }
-    if (i == m->count - 1) {
-      *entryCount = (int)(i - *entryOffset + 1);
-      break;
-    }
-  }
-}
-
 static void dumpMMMatrix(CommType *c, MMMatrix *mm)
 {
   MMEntry *entries = mm->entries;
 
-  for (int i = 0; i < mm->count; i++) {
-    FPRINTF(c->logFile, "%d %d: %f\n", entries[i].row, entries[i].col, entries[i].val);
+  for (size_t i = 0; i < mm->count; i++) {
+    FPRINTF(c->logFile,
+        "%lld %lld: %f\n",
+        entries[i].row,
+        entries[i].col,
+        entries[i].val);
   }
 }
 
@@ -262,28 +312,76 @@ static void createMMEntryDatatype(MPI_Datatype *entryType)
   displ[2]              = MPI_Aint_diff(displ[2], baseAddress);
 
   int blocklengths[3]   = { 1, 1, 1 };
-  MPI_Datatype types[3] = { MPI_INT, MPI_INT, MPI_DOUBLE };
+  MPI_Datatype types[3] = { MPI_GINT_TYPE, MPI_GINT_TYPE, MPI_DOUBLE };
   MPI_Type_create_struct(3, blocklengths, displ, types, entryType);
   MPI_Type_commit(entryType);
 }
 
-static void calculateMMSendCounts(
-    MMMatrix *m, int size, int totalNr, int *sendcounts, int *senddispls)
+static CG_GINT arrayRowPtr(void *ctx, CG_GINT row)
 {
-  int cursor = 0;
+  return ((CG_GINT *)ctx)[row];
+}
+
+/**
+ * @brief Split the rows of a sorted matrix among the ranks.
+ *
+ * Builds the global row pointer of the sorted entries and determines the first
+ * row of every rank with partitionStartRow. The entries of a rank are then a
+ * contiguous range starting at the row pointer of its first row. With
+ * DIST_GRAPH the matrix is partitioned and renumbered by partitionGraph first.
+ *
+ * @param[in,out] m Complete matrix sorted by rows
+ * @param size Number of ranks
+ * @param totalNr Total number of rows
+ * @param type Distribution type
+ * @param[out] startRows First row of every rank, startRows[size] is totalNr
+ * @param[out] sendcounts Number of entries of every rank
+ * @param[out] senddispls Offset of the first entry of every rank
+ */
+static void calculateMMSendCounts(MMMatrix *m,
+    int size,
+    CG_GINT totalNr,
+    DistributionType type,
+    CG_GINT *startRows,
+    CG_GINT *sendcounts,
+    CG_GINT *senddispls)
+{
+  // Graph partitioning renumbers the rows, the row pointer refers to the new order
+  if (type == DIST_GRAPH) {
+    partitionGraph(m, size, startRows);
+  }
+
+  CG_GINT *rowPtr =
+      (CG_GINT *)allocate(ARRAY_ALIGNMENT, (totalNr + 1) * sizeof(CG_GINT));
+
+  for (CG_GINT i = 0; i <= totalNr; i++) {
+    rowPtr[i] = 0;
+  }
+  for (size_t i = 0; i < m->count; i++) {
+    rowPtr[m->entries[i].row + 1]++;
+  }
+  for (CG_GINT i = 0; i < totalNr; i++) {
+    rowPtr[i + 1] += rowPtr[i];
+  }
+
+  if (type != DIST_GRAPH) {
+    for (int i = 0; i <= size; i++) {
+      startRows[i] = partitionStartRow(type, totalNr, arrayRowPtr, rowPtr, i, size);
+    }
+  }
+
   for (int i = 0; i < size; i++) {
-    int numRows  = sizeOfRank(i, size, totalNr);
-    int startRow = cursor;
-    cursor += numRows;
-    int stopRow = cursor - 1;
-    scanMM(m, startRow, stopRow, &sendcounts[i], &senddispls[i]);
-    printf("Rank %d count %d displ %d start %d stop %d\n",
+    senddispls[i] = rowPtr[startRows[i]];
+    sendcounts[i] = rowPtr[startRows[i + 1]] - senddispls[i];
+    printf("Rank %d count %lld displ %lld start %lld stop %lld\n",
         i,
         sendcounts[i],
         senddispls[i],
-        startRow,
-        stopRow);
+        startRows[i],
+        startRows[i + 1] - 1);
   }
+
+  free(rowPtr);
 }
 
 /**
@@ -291,13 +389,13 @@ static void calculateMMSendCounts(
  *
  * This function examines every matrix entry to find column indices that reference rows
  * owned by other ranks (external elements). Each unique external is recorded once in
- * the extLocalToGlobal array and indexed in the extLookup binary search tree.
+ * the extLocalToGlobal array and indexed in the extLookup binary search tree. The
+ * array grows by doubling, so its size follows the actual number of externals.
  *
- * @param c Communication structure (for error handling)
  * @param A The local matrix partition to scan
  * @param[out] extLookup Binary search tree mapping global column index → external array index
- * @param[out] extLocalToGlobal Array mapping external index → global column index
- * @return Number of unique external elements found
+ * @param[out] extCount Number of unique external elements found
+ * @return Array mapping external index → global column index, to be freed by the caller
  *
  * Algorithm:
  * For each matrix entry (row, col):
@@ -306,38 +404,41 @@ static void calculateMMSendCounts(
  *   - If new: insert into extLookup, add to extLocalToGlobal, increment counter
  *   - If already seen: skip (we only need each external once)
  */
-static int identifyExternals(
-    CommType *c, GMatrix *A, Bstree *extLookup, int *extLocalToGlobal)
+static CG_GINT *identifyExternals(GMatrix *A, Bstree *extLookup, int *extCount)
 {
-  CG_UINT *rowPtr  = A->rowPtr;
-  Entry *entries   = A->entries;
-  CG_UINT numRows  = A->nr;
-  CG_UINT startRow = A->startRow;
-  CG_UINT stopRow  = A->stopRow;
-  int extCount     = 0;
-
-  for (int i = 0; i < numRows; i++) {
+  CG_UINT *rowPtr           = A->rowPtr;
+  Entry *entries            = A->entries;
+  CG_UINT numRows           = A->nr;
+  CG_GINT startRow          = A->startRow;
+  CG_GINT stopRow           = A->stopRow;
+  int capacity              = 1024;
+  CG_GINT *extLocalToGlobal = (CG_GINT *)allocate(ARRAY_ALIGNMENT,
+      capacity * sizeof(CG_GINT));
+  int count                 = 0;
+
+  for (CG_UINT i = 0; i < numRows; i++) {
     for (CG_UINT j = rowPtr[i]; j < rowPtr[i + 1]; j++) {
-      CG_UINT curIndex = entries[j].col;
+      CG_GINT curIndex = entries[j].col;
 
       if (curIndex < startRow || curIndex > stopRow) {
         if (!bstExists(extLookup, curIndex)) {
-          bstInsert(extLookup, curIndex, extCount);
-
-          if (extCount < MAX_EXTERNAL) {
-            extLocalToGlobal[extCount] = (int)curIndex;
-          } else {
-            commAbort(c, "Must increase MAX_EXTERNAL");
+          bstInsert(extLookup, curIndex, count);
+
+          if (count == capacity) {
+            extLocalToGlobal = (CG_GINT *)reallocate(extLocalToGlobal,
+                ARRAY_ALIGNMENT,
+                2 * capacity * sizeof(CG_GINT),
+                capacity * sizeof(CG_GINT));
+            capacity *= 2;
           }
-          extCount++;
+          extLocalToGlobal[count++] = curIndex;
         }
       }
     }
   }
-#ifdef VERBOSE
-  printf("Rank %d: %d externals\n", c->rank, extCount);
-#endif
-  return extCount;
+
+  *extCount = count;
+  return extLocalToGlobal;
 }
 
 /**
@@ -365,8 +466,8 @@ static int identifyExternals(
  * 3. Count distinct source ranks
  */
 static int findExternalOwningRanks(CommType *c,
-    const int startRow,
-    const int *extLocalToGlobal,
+    const CG_GINT startRow,
+    const CG_GINT *extLocalToGlobal,
     const int extCount,
     int *recvFromNeighbors,
     int *extOwningRank)
@@ -377,13 +478,19 @@ static int findExternalOwningRanks(CommType *c,
     recvFromNeighbors[i] = -1;
   }
 
-  int globalIndexOffsets[size];
+  CG_GINT globalIndexOffsets[size];
   int sourceCount = 0;
 
-  MPI_Allgather(&startRow, 1, MPI_INT, globalIndexOffsets, 1, MPI_INT, MPI_COMM_WORLD);
+  MPI_Allgather(&startRow,
+      1,
+      MPI_GINT_TYPE,
+      globalIndexOffsets,
+      1,
+      MPI_GINT_TYPE,
+      MPI_COMM_WORLD);
 
   for (int i = 0; i < extCount; i++) {
-    int globalIndex = extLocalToGlobal[i];
+    CG_GINT globalIndex = extLocalToGlobal[i];
 
     for (int j = size - 1; j >= 0; j--) {
       if (globalIndexOffsets[j] <= globalIndex) {
@@ -512,12 +619,14 @@ static void retrieveTopology(CommType *c)
  *
  * Prints the application banner along with matrix format, precision, and
  * integer type configuration. This is typically called once at startup.
+ *
+ * @param format Name of the selected matrix format
  */
-static void printConfigInfo(void)
+static void printConfigInfo(const char *format)
 {
   printf(BANNER "\n");
   printf("Using %s matrix format, %s precision floats and integer type %s\n\n",
-      FMT,
+      format,
       PRECISION_STRING,
       UINT_STRING);
 }
@@ -551,7 +660,7 @@ static void printAffinityInfo(int rank, const char *host, pid_t masterPid)
  * @brief Print startup banner with system and configuration information.
  *
  * This function prints a comprehensive startup banner that includes:
- * - Application banner and compile-time configuration
+ * - Application banner, matrix format and compile-time configuration
  * - MPI rank information (if running with multiple processes)
  * - OpenMP thread count (if compiled with OpenMP support)
  * - Per-process hostname and PID information
@@ -560,8 +669,9 @@ static void printAffinityInfo(int rank, const char *host, pid_t masterPid)
  * The output is synchronized across MPI ranks to ensure readable output.
  *
  * @param c Communication structure containing rank and size information
+ * @param format Name of the selected matrix format
  */
-void commPrintBanner(CommType *c)
+void commPrintBanner(CommType *c, const char *format)
 {
   int rank = c->rank;
   int size = c->size;
@@ -574,7 +684,7 @@ void commPrintBanner(CommType *c)
 
   // Print banner and configuration (master only in MPI mode, or always in single-process mode)
   if (commIsMaster(c)) {
-    printConfigInfo();
+    printConfigInfo(format);
 
     if (size > 1) {
       printf("MPI parallel using %d ranks\n", size);
@@ -626,73 +736,99 @@ void commPrintBanner(CommType *c)
 #endif
 }
 
-void commDistributeMatrix(CommType *c, MMMatrix *m, MMMatrix *mLocal)
+/**
+ * @brief Distribute a Matrix Market matrix read on the master rank row wise.
+ *
+ * All counts and indices are 64 bit. As the per rank entry counts and offsets
+ * may exceed the int range of MPI_Scatterv the entries are sent point to point
+ * in chunks of at most MPI_CHUNK_COUNT elements.
+ *
+ * @param c Communication structure
+ * @param m Complete matrix sorted by rows, only valid on the master rank
+ * @param[out] mLocal Local part of the matrix
+ * @param type How rows are distributed, see partitionStartRow
+ */
+void commDistributeMatrix(
+    CommType *c, MMMatrix *m, MMMatrix *mLocal, DistributionType type)
 {
 #ifdef _MPI
   int rank = c->rank;
   int size = c->size;
-  int totalCounts[2];
+  CG_GINT totalCounts[2];
 
   if (rank == 0) {
     totalCounts[0] = m->nr;
     totalCounts[1] = m->nnz;
   }
 
-  int result = MPI_Bcast(&totalCounts, 2, MPI_INT, 0, MPI_COMM_WORLD);
+  int result = MPI_Bcast(&totalCounts, 2, MPI_GINT_TYPE, 0, MPI_COMM_WORLD);
   if (result != MPI_SUCCESS) {
     commAbort(c, "MPI_Bcast failed during matrix distribution");
   }
-  int totalNr  = totalCounts[0];
-  int totalNnz = totalCounts[1];
+  CG_GINT totalNr  = totalCounts[0];
+  CG_GINT totalNnz = totalCounts[1];
 
   MPI_Datatype entryType;
   createMMEntryDatatype(&entryType);
 
-  int sendcounts[size];
-  int senddispls[size];
+  CG_GINT startRows[size + 1];
+  CG_GINT sendcounts[size];
+  CG_GINT senddispls[size];
 
   if (commIsMaster(c)) {
-    calculateMMSendCounts(m, size, totalNr, sendcounts, senddispls);
+    calculateMMSendCounts(m, size, totalNr, type, startRows, sendcounts, senddispls);
   }
 
-  int count;
-  result = MPI_Scatter(sendcounts, 1, MPI_INT, &count, 1, MPI_INT, 0, MPI_COMM_WORLD);
+  result = MPI_Bcast(startRows, size + 1, MPI_GINT_TYPE, 0, MPI_COMM_WORLD);
+  if (result != MPI_SUCCESS) {
+    commAbort(c, "MPI_Bcast failed during matrix distribution");
+  }
+
+  CG_GINT count;
+  result = MPI_Scatter(
+      sendcounts, 1, MPI_GINT_TYPE, &count, 1, MPI_GINT_TYPE, 0, MPI_COMM_WORLD);
   if (result != MPI_SUCCESS) {
     commAbort(c, "MPI_Scatter failed during matrix distribution");
   }
 
+  if (count <= 0) {
+    commAbort(c, "No matrix entries received");
+  }
+  if ((unsigned long long)count > CG_UINT_MAX) {
+    commAbort(c, "Local matrix part exceeds index type, use more ranks or UINT_TYPE=ULL");
+  }
+
   mLocal->count    = count;
   mLocal->totalNr  = totalNr;
   mLocal->totalNnz = totalNnz;
   mLocal->entries  = (MMEntry *)allocate(ARRAY_ALIGNMENT, count * sizeof(MMEntry));
 
-  result           = MPI_Scatterv(m->entries,
-      sendcounts,
-      senddispls,
-      entryType,
-      mLocal->entries,
-      count,
-      entryType,
-      0,
-      MPI_COMM_WORLD);
+  if (commIsMaster(c)) {
+    for (int i = 1; i < size && result == MPI_SUCCESS; i++) {
+      result = commSendLarge(m->entries + senddispls[i],
+          sendcounts[i],
+          entryType,
+          i,
+          MPI_TAG_DISTRIBUTE);
+    }
+    memcpy(mLocal->entries, m->entries + senddispls[0], count * sizeof(MMEntry));
+  } else {
+    result = commRecvLarge(mLocal->entries, count, entryType, 0, MPI_TAG_DISTRIBUTE);
+  }
   if (result != MPI_SUCCESS) {
-    commAbort(c, "MPI_Scatterv failed during matrix distribution");
+    commAbort(c, "Sending matrix entries failed during matrix distribution");
   }
 
-  mLocal->startRow = mLocal->entries[0].row;
-  mLocal->stopRow  = mLocal->entries[count - 1].row;
+  mLocal->startRow = startRows[rank];
+  mLocal->stopRow  = startRows[rank + 1] - 1;
   mLocal->nr       = mLocal->stopRow - mLocal->startRow + 1;
   mLocal->nnz      = count;
 
-  if (count > 0) {
-    printf("Rank %d count %zu start %d stop %d\n",
-        rank,
-        mLocal->count,
-        mLocal->startRow,
-        mLocal->stopRow);
-  } else {
-    commAbort(c, "No matrix entries received");
-  }
+  printf("Rank %d count %zu start %lld stop %lld\n",
+      rank,
+      mLocal->count,
+      mLocal->startRow,
+      mLocal->stopRow);
 
   MPI_Type_free(&entryType);
 #else
@@ -701,6 +837,8 @@ void commDistributeMatrix(CommType *c, MMMatrix *m, MMMatrix *mLocal)
   mLocal->count    = m->count;
   mLocal->nr       = m->nr;
   mLocal->nnz      = m->nnz;
+  mLocal->totalNr  = m->nr;
+  mLocal->totalNnz = m->nnz;
   mLocal->entries  = m->entries;
 #endif /* ifdef _MPI */
 }
@@ -767,7 +905,6 @@ void commDistributeMatrix(CommType *c, MMMatrix *m, MMMatrix *mLocal)
  * @param[in,out] m Distributed matrix to localize (column indices will be remapped)
  * 
  * @note This function is only active when compiled with _MPI defined
- * @note Uses MAX_EXTERNAL as a compile-time limit; will abort if exceeded
  * 
  * Complexity: O(nnz_local × log(extCount) + extCount × log(numRanks) + totalSendCount)
  */
@@ -779,7 +916,7 @@ void commLocalization(CommType *c, GMatrix *m)
 
 #ifdef VERBOSE
   FPRINTF(c->logFile,
-      "Rank %d of %d: num columns %d owns %d rows: %d to %d of total %d\n",
+      "Rank %d of %d: num columns %d owns %d rows: %lld to %lld of total %lld\n",
       rank,
       size,
       m->nc,
@@ -795,9 +932,12 @@ void commLocalization(CommType *c, GMatrix *m)
    *    rows. Build a binary search tree for fast duplicate detection and an
    *    array mapping external index (0-based) to global column index.
    ************************************************************************/
-  Bstree *extLookup     = bstNew();
-  int *extLocalToGlobal = (int *)allocate(ARRAY_ALIGNMENT, MAX_EXTERNAL * sizeof(int));
-  int extCount          = identifyExternals(c, m, extLookup, extLocalToGlobal);
+  Bstree *extLookup = bstNew();
+  int extCount;
+  CG_GINT *extLocalToGlobal = identifyExternals(m, extLookup, &extCount);
+#ifdef VERBOSE
+  printf("Rank %d: %d externals\n", rank, extCount);
+#endif
 
   /***********************************************************************
    *    Step 2:  Build dist Graph topology and init incoming edges
@@ -811,7 +951,7 @@ void commLocalization(CommType *c, GMatrix *m)
 
   // Find which rank owns each external and count how many we need from each source
   int sourceCount = findExternalOwningRanks(
-      c, (int)m->startRow, extLocalToGlobal, extCount, recvFromNeighbors, extOwningRank);
+      c, m->startRow, extLocalToGlobal, extCount, recvFromNeighbors, extOwningRank);
 
   // Create MPI distributed graph with incoming edges (sources + receive counts)
   setupTopology(c, sourceCount, recvFromNeighbors);
@@ -827,8 +967,8 @@ void commLocalization(CommType *c, GMatrix *m)
    *    consecutive. This enables efficient MPI_Neighbor_alltoallv communication.
    *    Then remap all matrix column indices from global to local (0-based).
    ************************************************************************/
-  int *extLocalToGlobalReordered =
-      (int *)allocate(ARRAY_ALIGNMENT, extCount * sizeof(int));
+  CG_GINT *extLocalToGlobalReordered =
+      (CG_GINT *)allocate(ARRAY_ALIGNMENT, extCount * sizeof(CG_GINT));
 
   {
     int *extLocalIndex = (int *)allocate(ARRAY_ALIGNMENT, extCount * sizeof(int));
@@ -836,7 +976,7 @@ void commLocalization(CommType *c, GMatrix *m)
 
     // Reorder externals: assign consecutive local RHS indices to externals from same rank
     // extLocalIndex[old_ext_idx] = new_local_rhs_idx (in range [numRows, numRows+extCount-1])
-    reorderExternals(numRows, extCount, extLocalIndex, extOwningRank);
+    reorderExternals(c, numRows, extCount, extLocalIndex, extOwningRank);
 
     // Build reordered mapping: extLocalToGlobalReordered[new_ext_idx] = global_col_idx
     // The new external index is (extLocalIndex[i] - numRows) for the i-th original external
@@ -877,12 +1017,112 @@ void commLocalization(CommType *c, GMatrix *m)
    *    Exchange external lists with neighbors to determine which local
    *    elements to send. Build elementsToSend array for efficient packing.
    ************************************************************************/
-  buildElementsToSend(c, (int)m->startRow, extLocalToGlobalReordered);
+  buildElementsToSend(c, m->startRow, extLocalToGlobalReordered);
 
   free(extLocalToGlobalReordered);
 #endif
 }
 
+/**
+ * @brief Apply a renumbering of the local rows to the exchange plan.
+ *
+ * Halo columns keep their position behind the local rows, only the local
+ * indices packed into the send buffer change.
+ *
+ * @param[in,out] c Communication structure with a completed localization
+ * @param oldToNew New local index of every local row
+ */
+void commRenumber(CommType *c, const CG_UINT *oldToNew)
+{
+#ifdef _MPI
+  for (int i = 0; i < c->totalSendCount; i++) {
+    c->elementsToSend[i] = (int)oldToNew[c->elementsToSend[i]];
+  }
+#endif
+}
+
+/**
+ * @brief Store the exchange plan built by commLocalization.
+ *
+ * Writes the neighbor lists, message counts and the local indices packed into
+ * the send buffer. Together with the localized matrix this is sufficient to
+ * skip commLocalization on a later run with the same number of ranks.
+ *
+ * @param c Communication structure with a completed localization
+ * @param fp File to write to
+ */
+void commWriteTopology(CommType *c, FILE *fp)
+{
+#ifdef _MPI
+  FWRITE(&c->indegree, sizeof(int), 1, fp);
+  FWRITE(&c->outdegree, sizeof(int), 1, fp);
+  FWRITE(&c->totalSendCount, sizeof(int), 1, fp);
+  FWRITE(c->sources, sizeof(int), c->indegree, fp);
+  FWRITE(c->recvCounts, sizeof(int), c->indegree, fp);
+  FWRITE(c->destinations, sizeof(int), c->outdegree, fp);
+  FWRITE(c->sendCounts, sizeof(int), c->outdegree, fp);
+  FWRITE(c->elementsToSend, sizeof(int), c->totalSendCount, fp);
+#endif
+}
+
+/**
+ * @brief Restore an exchange plan written by commWriteTopology.
+ *
+ * Reads the plan, recomputes the displacements, allocates the send buffer and
+ * recreates the distributed graph communicator with the stored neighbor order.
+ * This is a collective call.
+ *
+ * @param[in,out] c Communication structure to populate
+ * @param fp File to read from
+ */
+void commReadTopology(CommType *c, FILE *fp)
+{
+#ifdef _MPI
+  FREAD(&c->indegree, sizeof(int), 1, fp);
+  FREAD(&c->outdegree, sizeof(int), 1, fp);
+  FREAD(&c->totalSendCount, sizeof(int), 1, fp);
+
+  c->sources        = (int *)allocate(ARRAY_ALIGNMENT, c->indegree * sizeof(int));
+  c->recvCounts     = (int *)allocate(ARRAY_ALIGNMENT, c->indegree * sizeof(int));
+  c->rdispls        = (int *)allocate(ARRAY_ALIGNMENT, c->indegree * sizeof(int));
+  c->destinations   = (int *)allocate(ARRAY_ALIGNMENT, c->outdegree * sizeof(int));
+  c->sendCounts     = (int *)allocate(ARRAY_ALIGNMENT, c->outdegree * sizeof(int));
+  c->sdispls        = (int *)allocate(ARRAY_ALIGNMENT, c->outdegree * sizeof(int));
+  c->elementsToSend = (int *)allocate(ARRAY_ALIGNMENT, c->totalSendCount * sizeof(int));
+  c->sendBuffer =
+      (CG_FLOAT *)allocate(ARRAY_ALIGNMENT, c->totalSendCount * sizeof(CG_FLOAT));
+
+  FREAD(c->sources, sizeof(int), c->indegree, fp);
+  FREAD(c->recvCounts, sizeof(int), c->indegree, fp);
+  FREAD(c->destinations, sizeof(int), c->outdegree, fp);
+  FREAD(c->sendCounts, sizeof(int), c->outdegree, fp);
+  FREAD(c->elementsToSend, sizeof(int), c->totalSendCount, fp);
+
+  int j = 0;
+  for (int i = 0; i < c->indegree; i++) {
+    c->rdispls[i] = j;
+    j += c->recvCounts[i];
+  }
+
+  j = 0;
+  for (int i = 0; i < c->outdegree; i++) {
+    c->sdispls[i] = j;
+    j += c->sendCounts[i];
+  }
+
+  MPI_Dist_graph_create_adjacent(MPI_COMM_WORLD,
+      c->indegree,
+      c->sources,
+      c->recvCounts,
+      c->outdegree,
+      c->destinations,
+      c->sendCounts,
+      MPI_INFO_NULL,
+      0,
+      &c->communicator);
+#endif
+}
+
 void commExchange(CommType *c, CG_UINT numRows, CG_FLOAT *x)
 {
 #ifdef _MPI
@@ -896,6 +1136,7 @@ void commExchange(CommType *c, CG_UINT numRows, CG_FLOAT *x)
     sendBuffer[i] = x[elementsToSend[i]];
   }
 
+  double ts = getTimeStamp();
   MPI_Neighbor_alltoallv(sendBuffer,
       c->sendCounts,
       c->sdispls,
@@ -905,23 +1146,297 @@ void commExchange(CommType *c, CG_UINT numRows, CG_FLOAT *x)
       c->rdispls,
       MPI_FLOAT_TYPE,
       c->communicator);
-
+  profilerSample(RegionHalo, ts, getTimeStamp());
 #endif
 }
 
 void commReduction(CG_FLOAT *v, int op)
 {
 #ifdef _MPI
+  double ts = getTimeStamp();
   if (op == MAX) {
     MPI_Allreduce(MPI_IN_PLACE, v, 1, MPI_FLOAT_TYPE, MPI_MAX, MPI_COMM_WORLD);
   } else if (op == SUM) {
     MPI_Allreduce(MPI_IN_PLACE, v, 1, MPI_FLOAT_TYPE, MPI_SUM, MPI_COMM_WORLD);
   }
+  profilerSample(RegionReduction, ts, getTimeStamp());
+#endif
+}
+
+void commReduceSum(size_t *v)
+{
+#ifdef _MPI
+  unsigned long long value = *v;
+  MPI_Allreduce(MPI_IN_PLACE, &value, 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM, MPI_COMM_WORLD);
+  *v = value;
+#endif
+}
+
+// Bytes sent and received in one halo exchange summed over all ranks
+size_t commExchangeBytes(CommType *c)
+{
+  size_t words = 0;
+#ifdef _MPI
+  for (int i = 0; i < c->outdegree; i++) {
+    words += c->sendCounts[i];
+  }
+  for (int i = 0; i < c->indegree; i++) {
+    words += c->recvCounts[i];
+  }
+  commReduceSum(&words);
+#endif
+  return sizeof(CG_FLOAT) * words;
+}
+
+/**
+ * @brief Register the profiler regions of the MPI calls.
+ *
+ * Collective call. The halo exchange is modelled with the bytes sent and
+ * received by all ranks, the reduction with no traffic.
+ *
+ * @param c Communication structure after commLocalization
+ * @param exchange Region enclosing commExchange
+ * @param reduction Region enclosing commReduction
+ */
+void commRegisterRegions(CommType *c, int exchange, int reduction)
+{
+  RegionHalo      = profilerRegister("halo", 0, commExchangeBytes(c), exchange);
+  RegionReduction = profilerRegister("allreduce", 0, 0, reduction);
+}
+
+/**
+ * @brief Print how evenly rows and non zeroes are distributed among the ranks.
+ *
+ * The imbalance is the maximum divided by the average over all ranks.
+ *
+ * @param c Communication structure
+ * @param m Local matrix part
+ */
+void commPrintBalance(CommType *c, GMatrix *m)
+{
+#ifdef _MPI
+  CG_GINT local[2] = { m->nr, m->nnz };
+  CG_GINT minimum[2], maximum[2], sum[2];
+
+  MPI_Reduce(local, minimum, 2, MPI_GINT_TYPE, MPI_MIN, 0, MPI_COMM_WORLD);
+  MPI_Reduce(local, maximum, 2, MPI_GINT_TYPE, MPI_MAX, 0, MPI_COMM_WORLD);
+  MPI_Reduce(local, sum, 2, MPI_GINT_TYPE, MPI_SUM, 0, MPI_COMM_WORLD);
+
+  if (commIsMaster(c)) {
+    printf("Distribution rows: min %lld max %lld imbalance %.2f\n",
+        minimum[0],
+        maximum[0],
+        (double)maximum[0] * c->size / sum[0]);
+    printf("Distribution nnz:  min %lld max %lld imbalance %.2f\n",
+        minimum[1],
+        maximum[1],
+        (double)maximum[1] * c->size / sum[1]);
+  }
+#endif
+}
+
+#ifdef _MPI
+// Degree histogram with integer bins, at most PATTERN_BINS lines
+static void printDegreeHistogram(int *degree, int size, int minDegree, int maxDegree)
+{
+  int range               = maxDegree - minDegree + 1;
+  int bins                = MIN(PATTERN_BINS, range);
+  int width               = (range + bins - 1) / bins;
+  int count[PATTERN_BINS] = { 0 };
+
+  for (int i = 0; i < size; i++) {
+    count[(degree[i] - minDegree) / width]++;
+  }
+
+  printf("Neighbors      ranks\n");
+  for (int b = 0; b < bins; b++) {
+    int lo = minDegree + b * width;
+    int hi = MIN(lo + width - 1, maxDegree);
+
+    if (lo > maxDegree) {
+      break;
+    }
+    if (lo == hi) {
+      printf("%9d %10d\n", lo, count[b]);
+    } else {
+      printf("%4d - %-4d%10d\n", lo, hi, count[b]);
+    }
+  }
+}
+
+// Dense matrix of the kB sent from every rank (rows) to every rank (columns)
+static void printPatternMatrix(int size, int *degree, int *displs, int *dest, int *count)
+{
+  double kB[size * size];
+
+  memset(kB, 0, sizeof(kB));
+  for (int i = 0; i < size; i++) {
+    for (int j = 0; j < degree[i]; j++) {
+      int k = displs[i] + j;
+
+      kB[i * size + dest[k]] = 1.0E-03 * sizeof(CG_FLOAT) * count[k];
+    }
+  }
+
+  printf("kB per exchange, source rank by row, destination rank by column\n");
+  printf("    ");
+  for (int j = 0; j < size; j++) {
+    printf(" %8d", j);
+  }
+  printf("\n");
+  for (int i = 0; i < size; i++) {
+    printf("%4d", i);
+    for (int j = 0; j < size; j++) {
+      printf(" %8.2f", kB[i * size + j]);
+    }
+    printf("\n");
+  }
+}
+
+static void printPattern(int size, int *degree, int *displs, int *dest, int *count)
+{
+  int messages  = 0;
+  int minDegree = degree[0];
+  int maxDegree = degree[0];
+  int minCount  = INT_MAX;
+  int maxCount  = 0;
+  int maxSource = 0;
+  int maxDest   = 0;
+  double rankMax = 0.0;
+  double words   = 0.0;
+
+  for (int i = 0; i < size; i++) {
+    double rankWords = 0.0;
+
+    minDegree = MIN(minDegree, degree[i]);
+    maxDegree = MAX(maxDegree, degree[i]);
+    messages += degree[i];
+
+    for (int j = displs[i]; j < displs[i] + degree[i]; j++) {
+      rankWords += count[j];
+      minCount = MIN(minCount, count[j]);
+      if (count[j] > maxCount) {
+        maxCount  = count[j];
+        maxSource = i;
+        maxDest   = dest[j];
+      }
+    }
+    rankMax = MAX(rankMax, rankWords);
+    words += rankWords;
+  }
+
+  printf("Communication pattern per halo exchange\n");
+  printf("Messages %d, total %.2f kB\n", messages, 1.0E-03 * sizeof(CG_FLOAT) * words);
+  printf("Neighbors per rank: min %d, max %d, avg %.2f\n",
+      minDegree,
+      maxDegree,
+      (double)messages / size);
+  printDegreeHistogram(degree, size, minDegree, maxDegree);
+  if (messages > 0) {
+    printf("Message size: min %.2f kB, max %.2f kB (rank %d to %d), avg %.2f kB\n",
+        1.0E-03 * sizeof(CG_FLOAT) * minCount,
+        1.0E-03 * sizeof(CG_FLOAT) * maxCount,
+        maxSource,
+        maxDest,
+        1.0E-03 * sizeof(CG_FLOAT) * words / messages);
+    printf("Send volume per rank: max %.2f kB, avg %.2f kB, imbalance %.2f\n",
+        1.0E-03 * sizeof(CG_FLOAT) * rankMax,
+        1.0E-03 * sizeof(CG_FLOAT) * words / size,
+        rankMax * size / words);
+  }
+  if (size <= PATTERN_PRINT_RANKS) {
+    printPatternMatrix(size, degree, displs, dest, count);
+  }
+}
+
+// One line per message, ranks without communication do not show up
+static void writePatternCsv(
+    char *filename, int size, int *degree, int *displs, int *dest, int *count)
+{
+  FILE *fp = fopen(filename, "w");
+  if (fp == NULL) {
+    printf("Warning: Could not open communication matrix file %s\n", filename);
+    return;
+  }
+
+  FPRINTF(fp, "source,destination,elements,bytes\n");
+  for (int i = 0; i < size; i++) {
+    for (int j = displs[i]; j < displs[i] + degree[i]; j++) {
+      FPRINTF(fp, "%d,%d,%d,%zu\n", i, dest[j], count[j], sizeof(CG_FLOAT) * count[j]);
+    }
+  }
+  FCLOSE(fp);
+  printf("Wrote communication matrix to %s\n", filename);
+}
+#endif
+
+/**
+ * @brief Report the rank to rank communication of the halo exchange.
+ *
+ * Collective call. The master gathers the send lists of all ranks and prints
+ * the number of messages and bytes of one halo exchange, the distribution of
+ * the neighbor count and the message sizes. Up to PATTERN_PRINT_RANKS ranks
+ * the full communication matrix is printed.
+ *
+ * @param c Communication structure after commLocalization
+ * @param filename File for the communication matrix in CSV format, NULL skips it
+ */
+void commPrintPattern(CommType *c, char *filename)
+{
+#ifdef _MPI
+  int degree[c->size];
+  int displs[c->size];
+  int messages = 0;
+
+  if (c->size == 1) {
+    return;
+  }
+
+  MPI_Gather(&c->outdegree, 1, MPI_INT, degree, 1, MPI_INT, 0, MPI_COMM_WORLD);
+  if (commIsMaster(c)) {
+    for (int i = 0; i < c->size; i++) {
+      displs[i] = messages;
+      messages += degree[i];
+    }
+  }
+
+  int *dest  = (int *)allocate(ARRAY_ALIGNMENT, MAX(messages, 1) * sizeof(int));
+  int *count = (int *)allocate(ARRAY_ALIGNMENT, MAX(messages, 1) * sizeof(int));
+
+  MPI_Gatherv(c->destinations,
+      c->outdegree,
+      MPI_INT,
+      dest,
+      degree,
+      displs,
+      MPI_INT,
+      0,
+      MPI_COMM_WORLD);
+  MPI_Gatherv(c->sendCounts,
+      c->outdegree,
+      MPI_INT,
+      count,
+      degree,
+      displs,
+      MPI_INT,
+      0,
+      MPI_COMM_WORLD);
+
+  if (commIsMaster(c)) {
+    printPattern(c->size, degree, displs, dest, count);
+    if (filename != NULL) {
+      writePatternCsv(filename, c->size, degree, displs, dest, count);
+    }
+    printf(HLINE);
+  }
+
+  free(dest);
+  free(count);
 #endif
 }
 
 void commPrintConfig(
-    CommType *c, CG_UINT nr, CG_UINT nnz, CG_UINT startRow, CG_UINT stopRow)
+    CommType *c, CG_UINT nr, CG_UINT nnz, CG_GINT startRow, CG_GINT stopRow)
 {
 #ifdef _MPI
   FFLUSH(stdout);
@@ -932,7 +1447,7 @@ void commPrintConfig(
 
   for (int i = 0; i < c->size; i++) {
     if (i == c->rank) {
-      printf("Rank %d has %u rows (%u to %u) and %u nnz\n",
+      printf("Rank %d has %u rows (%lld to %lld) and %u nnz\n",
           c->rank,
           nr,
           startRow,
@@ -971,88 +1486,89 @@ void commMatrixDump(CommType *c, Matrix *m)
   int rank = c->rank;
   int size = c->size;
 
-#ifdef CRS
-  CG_UINT numRows = m->nr;
-  CG_UINT *rowPtr = m->rowPtr;
-  CG_UINT *colInd = m->colInd;
-  CG_FLOAT *val   = m->val;
+  if (m->format == FMT_CRS) {
+    CG_UINT numRows = m->nr;
+    CG_UINT *rowPtr = m->crs.rowPtr;
+    CG_UINT *colInd = m->crs.colInd;
+    CG_FLOAT *val   = m->crs.val;
 
-  if (commIsMaster(c)) {
-    printf("Matrix: %d total non zeroes, total number of rows %d\n",
-        m->totalNnz,
-        m->totalNr);
-  }
+    if (commIsMaster(c)) {
+      printf("Matrix: %lld total non zeroes, total number of rows %lld\n",
+          m->totalNnz,
+          m->totalNr);
+    }
 
-  for (int i = 0; i < size; i++) {
-    if (i == rank) {
-      printf("Rank %d: number of rows %d\n", rank, numRows);
+    for (int i = 0; i < size; i++) {
+      if (i == rank) {
+        printf("Rank %d: number of rows %d\n", rank, numRows);
 
-      for (int rowID = 0; rowID < numRows; rowID++) {
-        printf("Row [%d]: ", rowID);
+        for (int rowID = 0; rowID < numRows; rowID++) {
+          printf("Row [%d]: ", rowID);
 
-        for (int rowEntry = (int)rowPtr[rowID]; rowEntry < rowPtr[rowID + 1];
-            rowEntry++) {
-          printf("[%d]:%.2f ", colInd[rowEntry], val[rowEntry]);
-        }
+          for (int rowEntry = (int)rowPtr[rowID]; rowEntry < rowPtr[rowID + 1];
+              rowEntry++) {
+            printf("[%d]:%.2f ", colInd[rowEntry], val[rowEntry]);
+          }
 
-        printf("\n");
+          printf("\n");
+        }
+        FFLUSH(stdout);
       }
-      FFLUSH(stdout);
-    }
 #ifdef _MPI
-    MPI_Barrier(MPI_COMM_WORLD);
+      MPI_Barrier(MPI_COMM_WORLD);
 #endif
-  }
-#endif /* ifdef CRS */
-#ifdef SCS
-  printf("m->startRow = %d\n", m->startRow);
-  printf("m->stopRow = %d\n", m->stopRow);
-  printf("m->totalNr = %d\n", m->totalNr);
-  printf("m->totalNnz = %d\n", m->totalNnz);
-  printf("m->nr = %d\n", m->nr);
-  printf("m->nc = %d\n", m->nc);
-  printf("m->nnz = %d\n", m->nnz);
-  printf("m->C = %d\n", m->C);
-  printf("m->sigma = %d\n", m->sigma);
-  printf("m->nChunks = %d\n", m->nChunks);
-  printf("m->nrPadded = %d\n", m->nrPadded);
-
-  // Dump permutation arrays
-  printf("oldToNewPerm: ");
-  for (int i = 0; i < m->nr; ++i) {
-    printf("%d, ", m->oldToNewPerm[i]);
-  }
-  printf("\n");
-  printf("newToOldPerm: ");
-  for (int i = 0; i < m->nr; ++i) {
-    printf("%d, ", m->newToOldPerm[i]);
-  }
-  printf("\n");
+    }
+  } else if (m->format == FMT_SCS) {
+    SCSMatrix *s = &m->scs;
+
+    printf("m->startRow = %lld\n", m->startRow);
+    printf("m->stopRow = %lld\n", m->stopRow);
+    printf("m->totalNr = %lld\n", m->totalNr);
+    printf("m->totalNnz = %lld\n", m->totalNnz);
+    printf("m->nr = %d\n", m->nr);
+    printf("m->nc = %d\n", m->nc);
+    printf("m->nnz = %d\n", m->nnz);
+    printf("m->C = %d\n", s->C);
+    printf("m->sigma = %d\n", s->sigma);
+    printf("m->nChunks = %d\n", s->nChunks);
+    printf("m->nrPadded = %d\n", s->nrPadded);
+
+    // Dump permutation arrays
+    printf("oldToNewPerm: ");
+    for (int i = 0; i < m->nr; ++i) {
+      printf("%d, ", s->oldToNewPerm[i]);
+    }
+    printf("\n");
+    printf("newToOldPerm: ");
+    for (int i = 0; i < m->nr; ++i) {
+      printf("%d, ", s->newToOldPerm[i]);
+    }
+    printf("\n");
 
-  // Dump chunk data
-  printf("chunkLens: ");
-  for (int i = 0; i < m->nChunks; ++i) {
-    printf("%d, ", m->chunkLens[i]);
-  }
-  printf("\n");
-  printf("chunkPtr: ");
-  for (int i = 0; i < m->nChunks + 1; ++i) {
-    printf("%d, ", m->chunkPtr[i]);
-  }
-  printf("\n");
+    // Dump chunk data
+    printf("chunkLens: ");
+    for (int i = 0; i < s->nChunks; ++i) {
+      printf("%d, ", s->chunkLens[i]);
+    }
+    printf("\n");
+    printf("chunkPtr: ");
+    for (int i = 0; i < s->nChunks + 1; ++i) {
+      printf("%d, ", s->chunkPtr[i]);
+    }
+    printf("\n");
 
-  // Dump matrix data
-  printf("colInd: ");
-  for (int i = 0; i < m->nElems; ++i) {
-    printf("%d, ", m->colInd[i]);
-  }
-  printf("\n");
-  printf("val: ");
-  for (int i = 0; i < m->nElems; ++i) {
-    printf("%f, ", m->val[i]);
+    // Dump matrix data
+    printf("colInd: ");
+    for (int i = 0; i < s->nElems; ++i) {
+      printf("%d, ", s->colInd[i]);
+    }
+    printf("\n");
+    printf("val: ");
+    for (int i = 0; i < s->nElems; ++i) {
+      printf("%f, ", s->val[i]);
+    }
+    printf("\n");
   }
-  printf("\n");
-#endif /* ifdef SCS */
 }
 
 void commVectorDump(CommType *c, CG_FLOAT *v, CG_UINT size, char *name)
@@ -1079,7 +1595,7 @@ void commGMatrixDump(CommType *c, GMatrix *m)
   Entry *entries  = m->entries;
 
   FPRINTF(c->logFile,
-      "Matrix: %d total non zeroes, total number of rows %d\n",
+      "Matrix: %lld total non zeroes, total number of rows %lld\n",
       m->totalNnz,
       m->totalNr);
   FPRINTF(c->logFile,
@@ -1096,7 +1612,10 @@ void commGMatrixDump(CommType *c, GMatrix *m)
 
         for (int rowEntry = (int)rowPtr[rowID]; rowEntry < rowPtr[rowID + 1];
             rowEntry++) {
-          FPRINTF(c->logFile, "[%d]:%.2f ", entries[rowEntry].col, entries[rowEntry].val);
+          FPRINTF(c->logFile,
+              "[%lld]:%.2f ",
+              entries[rowEntry].col,
+              entries[rowEntry].val);
         }
 
         FPRINTF(c->logFile, "\n");
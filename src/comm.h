@@ -12,8 +12,10 @@
 #endif
 
 #include "matrix.h"
+#include "partition.h"
 
-#define MAX_EXTERNAL 6000000
+// MPI-3 message counts are int, larger transfers are split into chunks
+#define MPI_CHUNK_COUNT (1 << 30)
 
 #define BANNER                                                                           \
   "/ _\\_ __   __ _ _ __ ___  ___  / __\\ ___ _ __   ___| |__  \n"                       \
@@ -46,17 +48,31 @@ typedef struct {
 
 extern void commInit(CommType *c, int argc, char **argv);
 extern void commFinalize(CommType *c);
-extern void commDistributeMatrix(CommType *c, MMMatrix *m, MMMatrix *mLocal);
+extern void commDistributeMatrix(
+    CommType *c, MMMatrix *m, MMMatrix *mLocal, DistributionType type);
+extern void commPrintBalance(CommType *c, GMatrix *m);
+extern void commPrintPattern(CommType *c, char *filename);
 extern void commLocalization(CommType *c, GMatrix *m);
+extern void commRenumber(CommType *c, const CG_UINT *oldToNew);
 extern void commPrintConfig(
-    CommType *c, CG_UINT nr, CG_UINT nnz, CG_UINT startRow, CG_UINT stopRow);
+    CommType *c, CG_UINT nr, CG_UINT nnz, CG_GINT startRow, CG_GINT stopRow);
 extern void commGMatrixDump(CommType *c, GMatrix *m);
 extern void commMatrixDump(CommType *c, Matrix *m);
 extern void commVectorDump(CommType *c, CG_FLOAT *v, CG_UINT size, char *name);
+extern void commWriteTopology(CommType *c, FILE *fp);
+extern void commReadTopology(CommType *c, FILE *fp);
 extern void commExchange(CommType *c, CG_UINT numRows, CG_FLOAT *x);
 extern void commReduction(CG_FLOAT *v, int op);
-extern void commPrintBanner(CommType *c);
+extern void commReduceSum(size_t *v);
+extern size_t commExchangeBytes(CommType *c);
+extern void commRegisterRegions(CommType *c, int exchange, int reduction);
+extern void commPrintBanner(CommType *c, const char *format);
 extern void commAbort(CommType *c, char *msg);
+#if defined(_MPI)
+extern int commSendLarge(
+    const void *buf, size_t count, MPI_Datatype type, int dest, int tag);
+extern int commRecvLarge(void *buf, size_t count, MPI_Datatype type, int source, int tag);
+#endif
 
 static inline int commIsMaster(CommType *c)
 {
@@ -14,14 +14,22 @@
 #include "comm.h"
 #include "matrix.h"
 #include "matrixBinfile.h"
+#include "matrixCache.h"
 #include "parameter.h"
+#include "partition.h"
 #include "profiler.h"
+#include "reorder.h"
 #include "solver.h"
+#include "stream.h"
 #include "timing.h"
+#include "trace.h"
+#include "tune.h"
 #include "util.h"
 
 static void initMatrix(CommType *c, Parameter *p, GMatrix *m)
 {
+  DistributionType distribution = partitionType(p->distribution);
+
   if (strcmp(p->filename, "generate") == 0) {
     matrixGenerate(m, p, c->rank, c->size, false);
   } else if (strcmp(p->filename, "generate7P") == 0) {
@@ -37,14 +45,25 @@ static void initMatrix(CommType *c, Parameter *p, GMatrix *m)
         MMMatrixRead(&mm, p->filename);
       }
 
-      commDistributeMatrix(c, &mm, &mmLocal);
+      allocatePhase(MEM_DISTRIBUTE);
+      commDistributeMatrix(c, &mm, &mmLocal, distribution);
+      // Without MPI the local part is the read matrix
+      if (commIsMaster(c) && mm.entries != mmLocal.entries) {
+        free(mm.entries);
+      }
       matrixConvertfromMM(&mmLocal, m);
     } else if (strcmp(dot, ".bmx") == 0) {
 #ifdef _MPI
       if (commIsMaster(c)) {
         printf("Read BMX matrix\n");
       }
-      matrixBinRead(m, c, p->filename);
+      if (distribution == DIST_GRAPH) {
+        if (commIsMaster(c)) {
+          printf("Graph partitioning needs a MTX matrix, using nnz distribution\n");
+        }
+        distribution = DIST_NNZ;
+      }
+      matrixBinRead(m, c, p->filename, distribution);
 #else
       printf("Binary matrix files are only supported with MPI!\n");
       exit(EXIT_SUCCESS);
@@ -63,40 +82,109 @@ int main(int argc, char **argv)
   commInit(&comm, argc, argv);
   initParameter(&param);
   parseArguments(&comm, &param, argc, argv);
-  commPrintBanner(&comm);
+  commPrintBanner(&comm, param.format);
 
   double ts;
-  GMatrix m;
-  double timeStart = getTimeStamp();
-  initMatrix(&comm, &param, &m);
-  commBarrier();
-  double timeStop = getTimeStamp();
-  if (commIsMaster(&comm)) {
-    printf("Init matrix took %.2fs\n", timeStop - timeStart);
+  Matrix sm;
+  sm.format = matrixFormat(param.format);
+  if (sm.format == FMT_SCS) {
+    sm.scs.C     = (CG_UINT)param.C;
+    sm.scs.sigma = (CG_UINT)param.sigma;
+    // The kernel writes y in the sorted row order but reads x in the original one
+    if (BenchType == CG && sm.scs.sigma > 1) {
+      if (commIsMaster(&comm)) {
+        printf("CG needs the SCS format with sigma 1, sigma %d sorts the rows\n",
+            param.sigma);
+      }
+      commFinalize(&comm);
+      exit(EXIT_FAILURE);
+    }
+  } else if (sm.format == FMT_STENCIL && !stencilInit(&sm.stencil, &param)) {
+    if (commIsMaster(&comm)) {
+      printf("The STENCIL format needs a generated matrix\n");
+    }
+    commFinalize(&comm);
+    exit(EXIT_FAILURE);
   }
-  timeStart = getTimeStamp();
-  commLocalization(&comm, &m);
+  // The stencil kernel generates the rows in the original numbering
+  if (sm.format == FMT_STENCIL && reorderType(param.reorder) != REORDER_NONE) {
+    if (commIsMaster(&comm)) {
+      printf("The STENCIL format ignores reordering %s\n", param.reorder);
+    }
+    param.reorder = "none";
+  }
+  double timeStart = getTimeStamp();
+  double timeStop;
 
-  Matrix sm;
-  convertMatrix(&sm, &m);
-  commBarrier();
-  timeStop = getTimeStamp();
-  if (commIsMaster(&comm)) {
-    printf(
-        "Parallel localization and matrix conversion took %.2fs\n", timeStop - timeStart);
+  allocatePhase(MEM_READ);
+  // The tuner needs the localized matrix before conversion
+  if (param.cachedir != NULL && BenchType != TUNE && cacheLoad(&comm, &param, &sm)) {
+    commBarrier();
+    timeStop = getTimeStamp();
+    if (commIsMaster(&comm)) {
+      printf("Load cached matrix took %.2fs\n", timeStop - timeStart);
+    }
+  } else {
+    GMatrix m;
+    timeStart = getTimeStamp();
+    initMatrix(&comm, &param, &m);
+    commPrintBalance(&comm, &m);
+    commBarrier();
+    timeStop = getTimeStamp();
+    if (commIsMaster(&comm)) {
+      printf("Init matrix took %.2fs\n", timeStop - timeStart);
+    }
+    timeStart = getTimeStamp();
+    allocatePhase(MEM_LOCALIZE);
+    commLocalization(&comm, &m);
+    reorderMatrix(&comm, &param, &m);
+
+    if (BenchType == TUNE) {
+      tuneFormat(&comm, &param, &m);
+      free(m.rowPtr);
+      free(m.entries);
+      free(m.newToOld);
+      commFinalize(&comm);
+      return EXIT_SUCCESS;
+    }
+
+    allocatePhase(MEM_CONVERT);
+    convertMatrix(&sm, &m);
+    commBarrier();
+    timeStop = getTimeStamp();
+    if (commIsMaster(&comm)) {
+      printf("Parallel localization and matrix conversion took %.2fs\n",
+          timeStop - timeStart);
+    }
+
+    if (param.cachedir != NULL) {
+      cacheStore(&comm, &param, &sm);
+    }
   }
 
-  size_t factorFlops[NUMREGIONS];
-  size_t factorWords[NUMREGIONS];
+  allocatePhase(MEM_SOLVE);
+  profilerInit(&comm);
+  solverRegisterRegions(&comm, &sm, param.xreuse);
 
-  factorFlops[DDOT]   = m.totalNr;
-  factorWords[DDOT]   = 3 * sizeof(CG_FLOAT) * m.totalNr / 2;
-  factorFlops[WAXPBY] = m.totalNr;
-  factorWords[WAXPBY] = 3 * sizeof(CG_FLOAT) * m.totalNr;
-  factorFlops[SPMVM]  = m.totalNnz;
-  factorWords[SPMVM]  = (sizeof(CG_FLOAT) * m.totalNnz) + (sizeof(CG_UINT) * m.totalNnz);
+  // Attainable bandwidth per region: triad for waxpby, load only for the read
+  // dominated spMVM and ddot
+  if (param.stream > 0) {
+    double stream[NUMSTREAM];
 
-  profilerInit(factorFlops, factorWords);
+    streamCalibrate(&comm, param.stream, stream);
+    profilerSetBandwidth(RegionWaxpby, stream[STREAM_TRIAD]);
+    profilerSetBandwidth(RegionSpMVM, stream[STREAM_LOAD]);
+    profilerSetBandwidth(RegionDdot, stream[STREAM_LOAD]);
+  }
+  if (param.membw > 0.0) {
+    profilerSetBandwidth(RegionWaxpby, param.membw);
+    profilerSetBandwidth(RegionSpMVM, param.membw);
+    profilerSetBandwidth(RegionDdot, param.membw);
+  }
+
+  if (param.trace != NULL) {
+    traceInit(&comm);
+  }
 
   int k = 0;
   switch (BenchType) {
@@ -111,16 +199,21 @@ int main(int argc, char **argv)
       printf("Test type: SPMVM\n");
     }
     const int itermax = param.itermax;
-    CG_FLOAT *x       = (CG_FLOAT *)allocate(ARRAY_ALIGNMENT, m.nc * sizeof(CG_FLOAT));
-    CG_FLOAT *y       = (CG_FLOAT *)allocate(ARRAY_ALIGNMENT, m.nr * sizeof(CG_FLOAT));
+    CG_FLOAT *x       = (CG_FLOAT *)allocate(ARRAY_ALIGNMENT, sm.nc * sizeof(CG_FLOAT));
+    CG_FLOAT *y       = (CG_FLOAT *)allocate(ARRAY_ALIGNMENT, sm.nr * sizeof(CG_FLOAT));
 
-    for (int i = 0; i < m.nr; i++) {
+    for (int i = 0; i < sm.nr; i++) {
       x[i] = (CG_FLOAT)1.0;
       y[i] = (CG_FLOAT)1.0;
     }
 
+    for (int i = 0; i < param.warmup; i++) {
+      spMVM(&sm, x, y);
+    }
+    profilerReset();
+
     for (k = 1; k < itermax; k++) {
-      PROFILE(SPMVM, spMVM(&sm, x, y));
+      PROFILE(RegionSpMVM, spMVM(&sm, x, y));
     }
     break;
   case GMRES:
@@ -132,7 +225,15 @@ int main(int argc, char **argv)
   default:;
   }
 
-  profilerPrint(&comm, k);
+  profilerPrint(&comm);
+  commPrintPattern(&comm, param.commcsv);
+  profilerPrintMemory(&comm, &sm);
+  if (param.json != NULL) {
+    profilerWriteJson(&comm, &param, &sm, k);
+  }
+  if (param.trace != NULL) {
+    profilerWriteTrace(&comm, param.trace);
+  }
   profilerFinalize();
   commFinalize(&comm);
 
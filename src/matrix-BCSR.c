@@ -0,0 +1,300 @@
+/* Copyright (C) NHR@FAU, University Erlangen-Nuremberg.
+ * All rights reserved. This file is part of SparseBench.
+ * Use of this source code is governed by a MIT style
+ * license that can be found in the LICENSE file. */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "allocate.h"
+#include "matrix.h"
+#include "profiler.h"
+#include "solver.h"
+#include "timing.h"
+
+// Local columns are blocked like the rows. The first and last block column are
+// shifted into x, so a block never reads outside of it.
+static inline CG_UINT blockStart(CG_UINT col, int b, int off, CG_UINT nc)
+{
+  long long s = ((long long)(col + off) / b) * b - off;
+
+  return (CG_UINT)MIN(MAX(s, 0), (long long)nc - b);
+}
+
+static inline CG_UINT blockRows(CG_UINT nr, int b, int off)
+{
+  return (nr + off + b - 1) / b;
+}
+
+// Counts the blocks of every block row into rowPtr[ib + 1] if rowPtr is given.
+// owner holds per block start column the last block row that touched it.
+static CG_UINT countBlocks(
+    GMatrix *im, int b, int off, CG_UINT nc, CG_UINT *owner, CG_UINT *rowPtr)
+{
+  CG_UINT nbr     = blockRows(im->nr, b, off);
+  CG_UINT nBlocks = 0;
+
+  for (CG_UINT c = 0; c < nc; c++) {
+    owner[c] = CG_UINT_MAX;
+  }
+
+  for (CG_UINT ib = 0; ib < nbr; ib++) {
+    CG_UINT first = ib == 0 ? 0 : ib * b - off;
+    CG_UINT last  = MIN((ib + 1) * b - off, im->nr);
+
+    for (CG_UINT j = im->rowPtr[first]; j < im->rowPtr[last]; j++) {
+      CG_UINT s = blockStart((CG_UINT)im->entries[j].col, b, off, nc);
+
+      if (owner[s] != ib) {
+        owner[s] = ib;
+        nBlocks++;
+      }
+    }
+
+    if (rowPtr != NULL) {
+      rowPtr[ib + 1] = nBlocks;
+    }
+  }
+
+  return nBlocks;
+}
+
+// The block size with the least matrix bytes wins, 1 is plain CRS with
+// block row pointers
+static int detectBlockSize(GMatrix *im, CG_UINT nc, CG_UINT *owner)
+{
+  size_t bestBytes = SIZE_MAX;
+  int best         = 1;
+
+  for (int b = 1; b <= BCSR_MAXB && b <= nc; b++) {
+    int off         = im->startRow % b;
+    CG_UINT nBlocks = countBlocks(im, b, off, nc, owner, NULL);
+    CG_UINT nbr     = blockRows(im->nr, b, off);
+    size_t bytes    = (size_t)nBlocks * (b * b * sizeof(CG_FLOAT) + sizeof(CG_UINT)) +
+                   (nbr + 1) * sizeof(CG_UINT);
+
+    if (bytes < bestBytes) {
+      bestBytes = bytes;
+      best      = b;
+    }
+  }
+
+  return best;
+}
+
+static void convertBCSR(Matrix *m, GMatrix *im)
+{
+  BCSRMatrix *sm = &m->bcsr;
+  CG_UINT nc     = m->nc;
+  CG_UINT *owner = (CG_UINT *)allocate(ARRAY_ALIGNMENT, MAX(nc, 1) * sizeof(CG_UINT));
+  CG_UINT *slot  = (CG_UINT *)allocate(ARRAY_ALIGNMENT, MAX(nc, 1) * sizeof(CG_UINT));
+  int b          = detectBlockSize(im, nc, owner);
+
+  int off        = m->startRow % b;
+
+  sm->b          = b;
+  sm->off        = off;
+  sm->nbr        = blockRows(m->nr, b, off);
+  sm->rowPtr     = (CG_UINT *)allocate(ARRAY_ALIGNMENT, (sm->nbr + 1) * sizeof(CG_UINT));
+  sm->rowPtr[0]  = 0;
+  sm->nBlocks    = countBlocks(im, b, off, nc, owner, sm->rowPtr);
+  sm->colInd     = (CG_UINT *)allocate(ARRAY_ALIGNMENT,
+      MAX(sm->nBlocks, 1) * sizeof(CG_UINT));
+  sm->val        = (CG_FLOAT *)allocate(ARRAY_ALIGNMENT,
+      MAX(sm->nBlocks, 1) * b * b * sizeof(CG_FLOAT));
+
+  for (size_t k = 0; k < (size_t)sm->nBlocks * b * b; k++) {
+    sm->val[k] = 0.0;
+  }
+  for (CG_UINT c = 0; c < nc; c++) {
+    owner[c] = CG_UINT_MAX;
+  }
+
+  for (CG_UINT ib = 0; ib < sm->nbr; ib++) {
+    CG_UINT k     = sm->rowPtr[ib];
+    CG_UINT first = ib == 0 ? 0 : ib * b - off;
+    CG_UINT last  = MIN((ib + 1) * b - off, m->nr);
+
+    for (CG_UINT i = first; i < last; i++) {
+      for (CG_UINT j = im->rowPtr[i]; j < im->rowPtr[i + 1]; j++) {
+        CG_UINT col = (CG_UINT)im->entries[j].col;
+        CG_UINT s   = blockStart(col, b, off, nc);
+
+        if (owner[s] != ib) {
+          owner[s]      = ib;
+          slot[s]       = k;
+          sm->colInd[k] = s;
+          k++;
+        }
+
+        sm->val[((size_t)slot[s] * b + i + off - ib * b) * b + col - s] +=
+            im->entries[j].val;
+      }
+    }
+  }
+
+  free(owner);
+  free(slot);
+  free(im->rowPtr);
+  free(im->entries);
+  im->rowPtr  = NULL;
+  im->entries = NULL;
+}
+
+static void writeBCSR(Matrix *m, FILE *fp)
+{
+  BCSRMatrix *sm = &m->bcsr;
+
+  FWRITE(sm->rowPtr, sizeof(CG_UINT), sm->nbr + 1, fp);
+  FWRITE(sm->colInd, sizeof(CG_UINT), sm->nBlocks, fp);
+  FWRITE(sm->val, sizeof(CG_FLOAT), (size_t)sm->nBlocks * sm->b * sm->b, fp);
+}
+
+static void readBCSR(Matrix *m, FILE *fp)
+{
+  BCSRMatrix *sm = &m->bcsr;
+
+  sm->rowPtr     = (CG_UINT *)allocate(ARRAY_ALIGNMENT, (sm->nbr + 1) * sizeof(CG_UINT));
+  sm->colInd     = (CG_UINT *)allocate(ARRAY_ALIGNMENT,
+      MAX(sm->nBlocks, 1) * sizeof(CG_UINT));
+  sm->val        = (CG_FLOAT *)allocate(ARRAY_ALIGNMENT,
+      MAX(sm->nBlocks, 1) * sm->b * sm->b * sizeof(CG_FLOAT));
+  FREAD(sm->rowPtr, sizeof(CG_UINT), sm->nbr + 1, fp);
+  FREAD(sm->colInd, sizeof(CG_UINT), sm->nBlocks, fp);
+  FREAD(sm->val, sizeof(CG_FLOAT), (size_t)sm->nBlocks * sm->b * sm->b, fp);
+}
+
+static void freeBCSR(Matrix *m)
+{
+  free(m->bcsr.rowPtr);
+  free(m->bcsr.colInd);
+  free(m->bcsr.val);
+}
+
+/**
+ * @brief Row lengths of the BCSR matrix without the zeros of the blocks.
+ *
+ * @param sm BCSR matrix
+ * @param nr Number of local rows
+ * @param len Row lengths, at least nr elements
+ */
+void bcsrRowLengths(BCSRMatrix *sm, CG_UINT nr, CG_FLOAT *len)
+{
+  int b = sm->b;
+
+  for (CG_UINT i = 0; i < nr; i++) {
+    CG_UINT ib = (i + sm->off) / b;
+    int r      = (i + sm->off) % b;
+
+    len[i]     = 0.0;
+    for (CG_UINT k = sm->rowPtr[ib]; k < sm->rowPtr[ib + 1]; k++) {
+      for (int c = 0; c < b; c++) {
+        len[i] += sm->val[((size_t)k * b + r) * b + c] != 0.0;
+      }
+    }
+  }
+}
+
+// Called with a constant block size, so every case of the kernel gets its own
+// fully unrolled block loop. Every x load is reused for the b rows of a block.
+static inline void blockRow(const CG_UINT *restrict rowPtr,
+    const CG_UINT *restrict colInd,
+    const CG_FLOAT *restrict val,
+    const int B,
+    CG_UINT ib,
+    const CG_FLOAT *restrict x,
+    CG_FLOAT *restrict sum)
+{
+  for (int r = 0; r < B; r++) {
+    sum[r] = 0.0;
+  }
+
+  for (CG_UINT k = rowPtr[ib]; k < rowPtr[ib + 1]; k++) {
+    const CG_FLOAT *a  = val + (size_t)k * B * B;
+    const CG_FLOAT *xb = x + colInd[k];
+
+    for (int r = 0; r < B; r++) {
+      for (int c = 0; c < B; c++) {
+        sum[r] += a[r * B + c] * xb[c];
+      }
+    }
+  }
+}
+
+void spMVMBCSR(Matrix *m, const CG_FLOAT *restrict x, CG_FLOAT *restrict y)
+{
+  CG_UINT *colInd  = m->bcsr.colInd;
+  CG_FLOAT *val    = m->bcsr.val;
+
+  CG_UINT numRows  = m->nr;
+  CG_UINT numBRows = m->bcsr.nbr;
+  CG_UINT *rowPtr  = m->bcsr.rowPtr;
+  int b            = m->bcsr.b;
+  int off          = m->bcsr.off;
+
+#pragma omp parallel
+  {
+    THREAD_TIMER_START;
+
+#pragma omp for schedule(OMP_SCHEDULE) nowait
+    for (int ib = 0; ib < numBRows; ib++) {
+      CG_FLOAT sum[BCSR_MAXB];
+
+      switch (b) {
+      case 1:
+        blockRow(rowPtr, colInd, val, 1, ib, x, sum);
+        break;
+      case 2:
+        blockRow(rowPtr, colInd, val, 2, ib, x, sum);
+        break;
+      case 3:
+        blockRow(rowPtr, colInd, val, 3, ib, x, sum);
+        break;
+      default:
+        blockRow(rowPtr, colInd, val, 4, ib, x, sum);
+      }
+
+      // the first and last block row may hold fewer rows
+      for (int r = 0; r < b; r++) {
+        long long i = (long long)ib * b - off + r;
+
+        if (i >= 0 && i < numRows) {
+          y[i] = sum[r];
+        }
+      }
+      THREAD_TIMER_WORK((rowPtr[ib + 1] - rowPtr[ib]) * b * b);
+    }
+
+    THREAD_TIMER_STOP(RegionSpMVM);
+  }
+}
+
+static size_t bytesBCSR(Matrix *m)
+{
+  BCSRMatrix *sm = &m->bcsr;
+
+  return (size_t)sm->nBlocks * (sm->b * sm->b * sizeof(CG_FLOAT) + sizeof(CG_UINT)) +
+         (sm->nbr + 1) * sizeof(CG_UINT);
+}
+
+// Blocks, block column indices and block row pointers are streamed once, x is
+// loaded once per block column
+static size_t trafficBCSR(Matrix *m, double xReuse)
+{
+  BCSRMatrix *sm = &m->bcsr;
+
+  return bytesBCSR(m) +
+         spMVMVectorTraffic(m->nr, m->nc, sm->nBlocks * sm->b, xReuse);
+}
+
+const MatrixFormat BCSRFormat = {
+  .name    = "BCSR",
+  .convert = convertBCSR,
+  .write   = writeBCSR,
+  .read    = readBCSR,
+  .free    = freeBCSR,
+  .bytes   = bytesBCSR,
+  .traffic = trafficBCSR,
+};
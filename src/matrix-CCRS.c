@@ -2,33 +2,116 @@
  * All rights reserved. This file is part of SparseBench.
  * Use of this source code is governed by a MIT style
  * license that can be found in the LICENSE file. */
+#include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 
-#include "CCRSMatrix.h"
+#include "allocate.h"
 #include "matrix.h"
+#include "profiler.h"
+#include "solver.h"
+#include "timing.h"
 
-void convertMatrix(Matrix *sm, GMatrix *m)
+// The GMatrix arrays are taken over. Both store interleaved {col, val} entries
+// with the value already in CG_FLOAT, so only a narrower column index type
+// needs work: the entries are then narrowed in place and the array is shrunk.
+static void convertCCRS(Matrix *m, GMatrix *im)
 {
-  sm = (Matrix *)m;
+  _Static_assert(sizeof(mEntry) <= sizeof(Entry), "CCRS entries must not be larger");
+
+  CCRSMatrix *sm = &m->ccrs;
+  Entry *entries = im->entries;
+
+  sm->rowPtr     = im->rowPtr;
+
+  if (sizeof(CG_UINT) != sizeof(CG_GINT) ||
+      offsetof(mEntry, val) != offsetof(Entry, val)) {
+    for (CG_UINT i = 0; i < im->nnz; i++) {
+      mEntry e = { (CG_UINT)entries[i].col, entries[i].val };
+
+      memcpy((mEntry *)entries + i, &e, sizeof(mEntry));
+    }
+  }
+  if (sizeof(mEntry) < sizeof(Entry)) {
+    entries = (Entry *)reallocate(entries,
+        ARRAY_ALIGNMENT,
+        im->nnz * sizeof(mEntry),
+        im->nnz * sizeof(Entry));
+  }
+
+  sm->entries = (mEntry *)entries;
+  im->rowPtr  = NULL;
+  im->entries = NULL;
+}
+
+static void writeCCRS(Matrix *m, FILE *fp)
+{
+  FWRITE(m->ccrs.rowPtr, sizeof(CG_UINT), m->nr + 1, fp);
+  FWRITE(m->ccrs.entries, sizeof(mEntry), m->nnz, fp);
 }
 
-void spMVM(Matrix *m, const CG_FLOAT *restrict x, CG_FLOAT *restrict y)
+static void readCCRS(Matrix *m, FILE *fp)
+{
+  CCRSMatrix *sm = &m->ccrs;
+
+  sm->rowPtr     = (CG_UINT *)allocate(ARRAY_ALIGNMENT, (m->nr + 1) * sizeof(CG_UINT));
+  sm->entries    = (mEntry *)allocate(ARRAY_ALIGNMENT, m->nnz * sizeof(mEntry));
+  FREAD(sm->rowPtr, sizeof(CG_UINT), m->nr + 1, fp);
+  FREAD(sm->entries, sizeof(mEntry), m->nnz, fp);
+}
+
+static void freeCCRS(Matrix *m)
+{
+  free(m->ccrs.rowPtr);
+  free(m->ccrs.entries);
+}
+
+void spMVMCCRS(Matrix *m, const CG_FLOAT *restrict x, CG_FLOAT *restrict y)
 {
   CG_UINT numRows = m->nr;
-  CG_UINT *rowPtr = m->rowPtr;
-  mEntry *entries = m->entries;
+  CG_UINT *rowPtr = m->ccrs.rowPtr;
+  mEntry *entries = m->ccrs.entries;
 
-#pragma omp parallel for schedule(OMP_SCHEDULE)
-  for (int i = 0; i < numRows; i++) {
-    CG_FLOAT sum = 0.0;
+#pragma omp parallel
+  {
+    THREAD_TIMER_START;
 
-    // loop over all elements in row
-    for (int j = rowPtr[i]; j < rowPtr[i + 1]; j++) {
-      sum += entries[j].val * x[entries[j].col];
+#pragma omp for schedule(OMP_SCHEDULE) nowait
+    for (int i = 0; i < numRows; i++) {
+      CG_FLOAT sum = 0.0;
+
+      // loop over all elements in row
+      for (CG_UINT j = rowPtr[i]; j < rowPtr[i + 1]; j++) {
+        sum += entries[j].val * x[entries[j].col];
+      }
+
+      y[i] = sum;
+      THREAD_TIMER_WORK(rowPtr[i + 1] - rowPtr[i]);
     }
 
-    y[i] = sum;
+    THREAD_TIMER_STOP(RegionSpMVM);
   }
 }
+
+static size_t bytesCCRS(Matrix *m)
+{
+  return (size_t)m->nnz * sizeof(mEntry) + (m->nr + 1) * sizeof(CG_UINT);
+}
+
+// Entries including their struct padding and row pointers are streamed once
+static size_t trafficCCRS(Matrix *m, double xReuse)
+{
+  return bytesCCRS(m) + spMVMVectorTraffic(m->nr, m->nc, m->nnz, xReuse);
+}
+
+const MatrixFormat CCRSFormat = {
+  .name    = "CCRS",
+  .convert = convertCCRS,
+  .write   = writeCCRS,
+  .read    = readCCRS,
+  .free    = freeCCRS,
+  .bytes   = bytesCCRS,
+  .traffic = trafficCCRS,
+};
@@ -4,61 +4,117 @@
  * license that can be found in the LICENSE file. */
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 
 #include "allocate.h"
 #include "matrix.h"
+#include "profiler.h"
+#include "solver.h"
+#include "timing.h"
 
-void convertMatrix(Matrix *sm, GMatrix *m)
+// The row pointers are taken over and the values are compacted in place into
+// the entry array of im, only the column indices need new memory
+static void convertCRS(Matrix *m, GMatrix *im)
 {
-  sm->startRow    = m->startRow;
-  sm->stopRow     = m->stopRow;
-  sm->totalNr     = m->totalNr;
-  sm->totalNnz    = m->totalNnz;
-  sm->nr          = m->nr;
-  sm->nc          = m->nc;
-  sm->nnz         = m->nnz;
+  CRSMatrix *sm  = &m->crs;
 
-  sm->rowPtr      = (CG_UINT *)allocate(ARRAY_ALIGNMENT, (m->nr + 1) * sizeof(CG_UINT));
-  sm->colInd      = (CG_UINT *)allocate(ARRAY_ALIGNMENT, m->nnz * sizeof(CG_UINT));
-  sm->val         = (CG_FLOAT *)allocate(ARRAY_ALIGNMENT, m->nnz * sizeof(CG_FLOAT));
+  sm->rowPtr     = im->rowPtr;
+  sm->colInd     = (CG_UINT *)allocate(ARRAY_ALIGNMENT, im->nnz * sizeof(CG_UINT));
 
-  Entry *entries  = m->entries;
+  Entry *entries = im->entries;
 
-  CG_UINT numRows = m->nr;
-  CG_UINT *rowPtr = m->rowPtr;
+  for (CG_UINT id = 0; id < im->nnz; id++) {
+    sm->colInd[id] = (CG_UINT)entries[id].col;
+  }
 
-  // convert to CRS format
-  for (int rowID = 0; rowID < numRows; rowID++) {
-    sm->rowPtr[rowID] = m->rowPtr[rowID];
+  for (CG_UINT id = 0; id < im->nnz; id++) {
+    CG_FLOAT val = entries[id].val;
 
-    // loop over all elements in Row
-    for (int id = m->rowPtr[rowID]; id < m->rowPtr[rowID + 1]; id++) {
-      sm->val[id]    = (CG_FLOAT)entries[id].val;
-      sm->colInd[id] = (CG_UINT)entries[id].col;
-    }
+    memcpy((CG_FLOAT *)entries + id, &val, sizeof(CG_FLOAT));
   }
 
-  sm->rowPtr[numRows] = m->rowPtr[numRows];
+  sm->val     = (CG_FLOAT *)reallocate(entries,
+      ARRAY_ALIGNMENT,
+      im->nnz * sizeof(CG_FLOAT),
+      im->nnz * sizeof(Entry));
+  im->rowPtr  = NULL;
+  im->entries = NULL;
+}
+
+static void writeCRS(Matrix *m, FILE *fp)
+{
+  FWRITE(m->crs.rowPtr, sizeof(CG_UINT), m->nr + 1, fp);
+  FWRITE(m->crs.colInd, sizeof(CG_UINT), m->nnz, fp);
+  FWRITE(m->crs.val, sizeof(CG_FLOAT), m->nnz, fp);
+}
+
+static void readCRS(Matrix *m, FILE *fp)
+{
+  CRSMatrix *sm = &m->crs;
+
+  sm->rowPtr    = (CG_UINT *)allocate(ARRAY_ALIGNMENT, (m->nr + 1) * sizeof(CG_UINT));
+  sm->colInd    = (CG_UINT *)allocate(ARRAY_ALIGNMENT, m->nnz * sizeof(CG_UINT));
+  sm->val       = (CG_FLOAT *)allocate(ARRAY_ALIGNMENT, m->nnz * sizeof(CG_FLOAT));
+  FREAD(sm->rowPtr, sizeof(CG_UINT), m->nr + 1, fp);
+  FREAD(sm->colInd, sizeof(CG_UINT), m->nnz, fp);
+  FREAD(sm->val, sizeof(CG_FLOAT), m->nnz, fp);
+}
+
+static void freeCRS(Matrix *m)
+{
+  free(m->crs.rowPtr);
+  free(m->crs.colInd);
+  free(m->crs.val);
 }
 
-void spMVM(Matrix *m, const CG_FLOAT *restrict x, CG_FLOAT *restrict y)
+void spMVMCRS(Matrix *m, const CG_FLOAT *restrict x, CG_FLOAT *restrict y)
 {
-  CG_UINT *colInd = m->colInd;
-  CG_FLOAT *val   = m->val;
+  CG_UINT *colInd = m->crs.colInd;
+  CG_FLOAT *val   = m->crs.val;
 
   CG_UINT numRows = m->nr;
-  CG_UINT *rowPtr = m->rowPtr;
+  CG_UINT *rowPtr = m->crs.rowPtr;
+
+#pragma omp parallel
+  {
+    THREAD_TIMER_START;
 
-#pragma omp parallel for schedule(OMP_SCHEDULE)
-  for (int i = 0; i < numRows; i++) {
-    CG_FLOAT sum = 0.0;
+#pragma omp for schedule(OMP_SCHEDULE) nowait
+    for (int i = 0; i < numRows; i++) {
+      CG_FLOAT sum = 0.0;
 
-    // loop over all elements in row
-    for (int j = rowPtr[i]; j < rowPtr[i + 1]; j++) {
-      sum += val[j] * x[colInd[j]];
+      // loop over all elements in row
+      for (CG_UINT j = rowPtr[i]; j < rowPtr[i + 1]; j++) {
+        sum += val[j] * x[colInd[j]];
+      }
+
+      y[i] = sum;
+      THREAD_TIMER_WORK(rowPtr[i + 1] - rowPtr[i]);
     }
 
-    y[i] = sum;
+    THREAD_TIMER_STOP(RegionSpMVM);
   }
 }
+
+static size_t bytesCRS(Matrix *m)
+{
+  return (size_t)m->nnz * (sizeof(CG_FLOAT) + sizeof(CG_UINT)) +
+         (m->nr + 1) * sizeof(CG_UINT);
+}
+
+// Values, column indices and row pointers are streamed once
+static size_t trafficCRS(Matrix *m, double xReuse)
+{
+  return bytesCRS(m) + spMVMVectorTraffic(m->nr, m->nc, m->nnz, xReuse);
+}
+
+const MatrixFormat CRSFormat = {
+  .name    = "CRS",
+  .convert = convertCRS,
+  .write   = writeCRS,
+  .read    = readCRS,
+  .free    = freeCRS,
+  .bytes   = bytesCRS,
+  .traffic = trafficCRS,
+};
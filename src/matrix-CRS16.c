@@ -0,0 +1,241 @@
+/* Copyright (C) NHR@FAU, University Erlangen-Nuremberg.
+ * All rights reserved. This file is part of SparseBench.
+ * Use of this source code is governed by a MIT style
+ * license that can be found in the LICENSE file. */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "allocate.h"
+#include "matrix.h"
+#include "profiler.h"
+#include "solver.h"
+#include "timing.h"
+
+static void allocateWide(CRS16Matrix *sm, CG_UINT wideNnz)
+{
+  sm->wideRow    = (CG_UINT *)allocate(ARRAY_ALIGNMENT,
+      MAX(sm->nWide, 1) * sizeof(CG_UINT));
+  sm->wideRowPtr = (CG_UINT *)allocate(ARRAY_ALIGNMENT,
+      (sm->nWide + 1) * sizeof(CG_UINT));
+  sm->wideColInd = (CG_UINT *)allocate(ARRAY_ALIGNMENT,
+      MAX(wideNnz, 1) * sizeof(CG_UINT));
+}
+
+// Every row stores its smallest column as base and 16 bit offsets to it. Rows
+// spanning more than 2^16 columns, e.g. with halo columns far behind the local
+// ones, keep full column indices in the wide arrays. The row pointers are taken
+// over and the values are compacted in place like in CRS.
+static void convertCRS16(Matrix *m, GMatrix *im)
+{
+  CRS16Matrix *sm = &m->crs16;
+  Entry *entries  = im->entries;
+  CG_UINT *rowPtr = im->rowPtr;
+  CG_UINT wideNnz = 0;
+
+  sm->rowPtr      = rowPtr;
+  sm->base        = (CG_UINT *)allocate(ARRAY_ALIGNMENT, m->nr * sizeof(CG_UINT));
+  sm->offset      = (uint16_t *)allocate(ARRAY_ALIGNMENT, m->nnz * sizeof(uint16_t));
+  sm->nWide       = 0;
+
+  for (CG_UINT i = 0; i < m->nr; i++) {
+    CG_UINT minCol = CG_UINT_MAX;
+    CG_UINT maxCol = 0;
+
+    for (CG_UINT j = rowPtr[i]; j < rowPtr[i + 1]; j++) {
+      minCol = MIN(minCol, (CG_UINT)entries[j].col);
+      maxCol = MAX(maxCol, (CG_UINT)entries[j].col);
+    }
+
+    if (rowPtr[i] == rowPtr[i + 1]) {
+      sm->base[i] = 0;
+    } else if (maxCol - minCol <= UINT16_MAX) {
+      sm->base[i] = minCol;
+      for (CG_UINT j = rowPtr[i]; j < rowPtr[i + 1]; j++) {
+        sm->offset[j] = (uint16_t)(entries[j].col - minCol);
+      }
+    } else {
+      sm->base[i] = CRS16_WIDE;
+      for (CG_UINT j = rowPtr[i]; j < rowPtr[i + 1]; j++) {
+        sm->offset[j] = 0;
+      }
+      sm->nWide++;
+      wideNnz += rowPtr[i + 1] - rowPtr[i];
+    }
+  }
+
+  allocateWide(sm, wideNnz);
+
+  CG_UINT k         = 0;
+  sm->wideRowPtr[0] = 0;
+  for (CG_UINT i = 0; i < m->nr; i++) {
+    if (sm->base[i] == CRS16_WIDE) {
+      CG_UINT start = sm->wideRowPtr[k];
+
+      for (CG_UINT j = rowPtr[i]; j < rowPtr[i + 1]; j++) {
+        sm->wideColInd[start + j - rowPtr[i]] = (CG_UINT)entries[j].col;
+      }
+      sm->wideRow[k]        = i;
+      sm->wideRowPtr[k + 1] = start + rowPtr[i + 1] - rowPtr[i];
+      k++;
+    }
+  }
+
+  for (CG_UINT id = 0; id < m->nnz; id++) {
+    CG_FLOAT val = entries[id].val;
+
+    memcpy((CG_FLOAT *)entries + id, &val, sizeof(CG_FLOAT));
+  }
+
+  sm->val     = (CG_FLOAT *)reallocate(entries,
+      ARRAY_ALIGNMENT,
+      m->nnz * sizeof(CG_FLOAT),
+      m->nnz * sizeof(Entry));
+  im->rowPtr  = NULL;
+  im->entries = NULL;
+}
+
+static void writeCRS16(Matrix *m, FILE *fp)
+{
+  CRS16Matrix *sm = &m->crs16;
+
+  FWRITE(sm->rowPtr, sizeof(CG_UINT), m->nr + 1, fp);
+  FWRITE(sm->base, sizeof(CG_UINT), m->nr, fp);
+  FWRITE(sm->offset, sizeof(uint16_t), m->nnz, fp);
+  FWRITE(sm->val, sizeof(CG_FLOAT), m->nnz, fp);
+  FWRITE(sm->wideRow, sizeof(CG_UINT), sm->nWide, fp);
+  FWRITE(sm->wideRowPtr, sizeof(CG_UINT), sm->nWide + 1, fp);
+  FWRITE(sm->wideColInd, sizeof(CG_UINT), sm->wideRowPtr[sm->nWide], fp);
+}
+
+static void readCRS16(Matrix *m, FILE *fp)
+{
+  CRS16Matrix *sm = &m->crs16;
+
+  sm->rowPtr      = (CG_UINT *)allocate(ARRAY_ALIGNMENT, (m->nr + 1) * sizeof(CG_UINT));
+  sm->base        = (CG_UINT *)allocate(ARRAY_ALIGNMENT, m->nr * sizeof(CG_UINT));
+  sm->offset      = (uint16_t *)allocate(ARRAY_ALIGNMENT, m->nnz * sizeof(uint16_t));
+  sm->val         = (CG_FLOAT *)allocate(ARRAY_ALIGNMENT, m->nnz * sizeof(CG_FLOAT));
+  FREAD(sm->rowPtr, sizeof(CG_UINT), m->nr + 1, fp);
+  FREAD(sm->base, sizeof(CG_UINT), m->nr, fp);
+  FREAD(sm->offset, sizeof(uint16_t), m->nnz, fp);
+  FREAD(sm->val, sizeof(CG_FLOAT), m->nnz, fp);
+
+  // The last wide row pointer holds the number of wide column indices
+  sm->wideRow    = (CG_UINT *)allocate(ARRAY_ALIGNMENT,
+      MAX(sm->nWide, 1) * sizeof(CG_UINT));
+  sm->wideRowPtr = (CG_UINT *)allocate(ARRAY_ALIGNMENT,
+      (sm->nWide + 1) * sizeof(CG_UINT));
+  FREAD(sm->wideRow, sizeof(CG_UINT), sm->nWide, fp);
+  FREAD(sm->wideRowPtr, sizeof(CG_UINT), sm->nWide + 1, fp);
+
+  CG_UINT wideNnz = sm->wideRowPtr[sm->nWide];
+  sm->wideColInd  = (CG_UINT *)allocate(ARRAY_ALIGNMENT,
+      MAX(wideNnz, 1) * sizeof(CG_UINT));
+  FREAD(sm->wideColInd, sizeof(CG_UINT), wideNnz, fp);
+}
+
+static void freeCRS16(Matrix *m)
+{
+  CRS16Matrix *sm = &m->crs16;
+
+  free(sm->rowPtr);
+  free(sm->base);
+  free(sm->offset);
+  free(sm->val);
+  free(sm->wideRow);
+  free(sm->wideRowPtr);
+  free(sm->wideColInd);
+}
+
+void spMVMCRS16(Matrix *m, const CG_FLOAT *restrict x, CG_FLOAT *restrict y)
+{
+  CG_UINT numRows     = m->nr;
+  CG_UINT *rowPtr     = m->crs16.rowPtr;
+  CG_UINT *base       = m->crs16.base;
+  uint16_t *offset    = m->crs16.offset;
+  CG_FLOAT *val       = m->crs16.val;
+
+  CG_UINT nWide       = m->crs16.nWide;
+  CG_UINT *wideRow    = m->crs16.wideRow;
+  CG_UINT *wideRowPtr = m->crs16.wideRowPtr;
+  CG_UINT *wideColInd = m->crs16.wideColInd;
+
+#pragma omp parallel
+  {
+    THREAD_TIMER_START;
+
+    // Both loops write disjoint rows of y and need no barrier in between
+#pragma omp for schedule(OMP_SCHEDULE) nowait
+    for (int i = 0; i < numRows; i++) {
+      if (base[i] == CRS16_WIDE) {
+        continue;
+      }
+
+      // The offsets are widened in registers and index x relative to the base
+      const CG_FLOAT *xRow = x + base[i];
+      CG_FLOAT sum         = 0.0;
+
+      for (CG_UINT j = rowPtr[i]; j < rowPtr[i + 1]; j++) {
+        sum += val[j] * xRow[offset[j]];
+      }
+
+      y[i] = sum;
+      THREAD_TIMER_WORK(rowPtr[i + 1] - rowPtr[i]);
+    }
+
+#pragma omp for schedule(OMP_SCHEDULE) nowait
+    for (int k = 0; k < nWide; k++) {
+      CG_UINT i        = wideRow[k];
+      CG_UINT len      = rowPtr[i + 1] - rowPtr[i];
+      CG_FLOAT *rowVal = val + rowPtr[i];
+      CG_UINT *colInd  = wideColInd + wideRowPtr[k];
+      CG_FLOAT sum     = 0.0;
+
+      for (CG_UINT j = 0; j < len; j++) {
+        sum += rowVal[j] * x[colInd[j]];
+      }
+
+      y[i] = sum;
+      THREAD_TIMER_WORK(len);
+    }
+
+    THREAD_TIMER_STOP(RegionSpMVM);
+  }
+}
+
+// The offsets of wide rows are stored but never loaded
+static size_t bytesCRS16(Matrix *m)
+{
+  CRS16Matrix *sm = &m->crs16;
+
+  return (size_t)m->nnz * (sizeof(CG_FLOAT) + sizeof(uint16_t)) +
+         (2 * (size_t)m->nr + 1) * sizeof(CG_UINT) +
+         (sm->wideRowPtr[sm->nWide] + 2 * (size_t)sm->nWide + 1) * sizeof(CG_UINT);
+}
+
+// Values, offsets of the narrow rows, row pointers and bases as well as the
+// wide column indices and their row lists are streamed once
+static size_t trafficCRS16(Matrix *m, double xReuse)
+{
+  CRS16Matrix *sm = &m->crs16;
+  size_t wideNnz  = sm->wideRowPtr[sm->nWide];
+  size_t matrix   = (size_t)m->nnz * sizeof(CG_FLOAT) +
+                  (m->nnz - wideNnz) * sizeof(uint16_t) +
+                  (2 * (size_t)m->nr + 1) * sizeof(CG_UINT) +
+                  (wideNnz + 2 * (size_t)sm->nWide + 1) * sizeof(CG_UINT);
+
+  return matrix + spMVMVectorTraffic(m->nr, m->nc, m->nnz, xReuse);
+}
+
+const MatrixFormat CRS16Format = {
+  .name    = "CRS16",
+  .convert = convertCRS16,
+  .write   = writeCRS16,
+  .read    = readCRS16,
+  .free    = freeCRS16,
+  .bytes   = bytesCRS16,
+  .traffic = trafficCRS16,
+};
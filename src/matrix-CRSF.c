@@ -0,0 +1,120 @@
+/* Copyright (C) NHR@FAU, University Erlangen-Nuremberg.
+ * All rights reserved. This file is part of SparseBench.
+ * Use of this source code is governed by a MIT style
+ * license that can be found in the LICENSE file. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "allocate.h"
+#include "matrix.h"
+#include "profiler.h"
+#include "solver.h"
+#include "timing.h"
+
+// Like CRS, but the values are rounded to float while they are compacted in
+// place into the entry array of im
+static void convertCRSF(Matrix *m, GMatrix *im)
+{
+  CRSFMatrix *sm = &m->crsf;
+
+  sm->rowPtr     = im->rowPtr;
+  sm->colInd     = (CG_UINT *)allocate(ARRAY_ALIGNMENT, im->nnz * sizeof(CG_UINT));
+
+  Entry *entries = im->entries;
+
+  for (CG_UINT id = 0; id < im->nnz; id++) {
+    sm->colInd[id] = (CG_UINT)entries[id].col;
+  }
+
+  for (CG_UINT id = 0; id < im->nnz; id++) {
+    float val = (float)entries[id].val;
+
+    memcpy((float *)entries + id, &val, sizeof(float));
+  }
+
+  sm->val     = (float *)reallocate(entries,
+      ARRAY_ALIGNMENT,
+      im->nnz * sizeof(float),
+      im->nnz * sizeof(Entry));
+  im->rowPtr  = NULL;
+  im->entries = NULL;
+}
+
+static void writeCRSF(Matrix *m, FILE *fp)
+{
+  FWRITE(m->crsf.rowPtr, sizeof(CG_UINT), m->nr + 1, fp);
+  FWRITE(m->crsf.colInd, sizeof(CG_UINT), m->nnz, fp);
+  FWRITE(m->crsf.val, sizeof(float), m->nnz, fp);
+}
+
+static void readCRSF(Matrix *m, FILE *fp)
+{
+  CRSFMatrix *sm = &m->crsf;
+
+  sm->rowPtr     = (CG_UINT *)allocate(ARRAY_ALIGNMENT, (m->nr + 1) * sizeof(CG_UINT));
+  sm->colInd     = (CG_UINT *)allocate(ARRAY_ALIGNMENT, m->nnz * sizeof(CG_UINT));
+  sm->val        = (float *)allocate(ARRAY_ALIGNMENT, m->nnz * sizeof(float));
+  FREAD(sm->rowPtr, sizeof(CG_UINT), m->nr + 1, fp);
+  FREAD(sm->colInd, sizeof(CG_UINT), m->nnz, fp);
+  FREAD(sm->val, sizeof(float), m->nnz, fp);
+}
+
+static void freeCRSF(Matrix *m)
+{
+  free(m->crsf.rowPtr);
+  free(m->crsf.colInd);
+  free(m->crsf.val);
+}
+
+void spMVMCRSF(Matrix *m, const CG_FLOAT *restrict x, CG_FLOAT *restrict y)
+{
+  CG_UINT *colInd = m->crsf.colInd;
+  float *val      = m->crsf.val;
+
+  CG_UINT numRows = m->nr;
+  CG_UINT *rowPtr = m->crsf.rowPtr;
+
+#pragma omp parallel
+  {
+    THREAD_TIMER_START;
+
+#pragma omp for schedule(OMP_SCHEDULE) nowait
+    for (int i = 0; i < numRows; i++) {
+      double sum = 0.0;
+
+      // values are widened on load, the products are summed in double
+      for (CG_UINT j = rowPtr[i]; j < rowPtr[i + 1]; j++) {
+        sum += (double)val[j] * x[colInd[j]];
+      }
+
+      y[i] = (CG_FLOAT)sum;
+      THREAD_TIMER_WORK(rowPtr[i + 1] - rowPtr[i]);
+    }
+
+    THREAD_TIMER_STOP(RegionSpMVM);
+  }
+}
+
+static size_t bytesCRSF(Matrix *m)
+{
+  return (size_t)m->nnz * (sizeof(float) + sizeof(CG_UINT)) +
+         (m->nr + 1) * sizeof(CG_UINT);
+}
+
+// Values, column indices and row pointers are streamed once
+static size_t trafficCRSF(Matrix *m, double xReuse)
+{
+  return bytesCRSF(m) + spMVMVectorTraffic(m->nr, m->nc, m->nnz, xReuse);
+}
+
+const MatrixFormat CRSFFormat = {
+  .name    = "CRSF",
+  .convert = convertCRSF,
+  .write   = writeCRSF,
+  .read    = readCRSF,
+  .free    = freeCRSF,
+  .bytes   = bytesCRSF,
+  .traffic = trafficCRSF,
+};
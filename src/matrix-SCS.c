@@ -8,6 +8,9 @@
 
 #include "allocate.h"
 #include "matrix.h"
+#include "profiler.h"
+#include "solver.h"
+#include "timing.h"
 
 static inline int compareDesc(const void *a, const void *b)
 {
@@ -30,19 +33,14 @@ static inline int compareDescSCS(const void *a, const void *b)
   return 0; // Stable if equal
 }
 
-void convertMatrix(Matrix *m, GMatrix *im)
+static void convertSCS(Matrix *sm, GMatrix *im)
 {
-  m->startRow = im->startRow;
-  m->stopRow  = im->stopRow;
-  m->totalNr  = im->totalNr;
-  m->totalNnz = im->totalNnz;
-  m->nr       = im->nr;
-  m->nc       = im->nr;
-  m->nnz      = im->nnz;
-  m->nChunks  = (m->nr + m->C - 1) / m->C;
-  m->nrPadded = m->nChunks * m->C;
-  m->C        = (CG_UINT)1;
-  m->sigma    = (CG_UINT)1;
+  SCSMatrix *m = &sm->scs;
+  CG_UINT nr   = sm->nr;
+
+  // Chunk height C and sorting scope sigma are set by the caller
+  m->nChunks   = (nr + m->C - 1) / m->C;
+  m->nrPadded  = m->nChunks * m->C;
 
   // (Temporary array) Assign an index to each row to use for row sorting
   SellCSigmaPair *elemsPerRow =
@@ -55,7 +53,7 @@ void convertMatrix(Matrix *m, GMatrix *im)
 
   // Collect the number of elements in each row
   CG_UINT *rowPtr = im->rowPtr;
-  for (int i = 0; i < m->nr; i++) {
+  for (int i = 0; i < nr; i++) {
     elemsPerRow[i].count = rowPtr[i + 1] - rowPtr[i];
   }
 
@@ -112,25 +110,25 @@ void convertMatrix(Matrix *m, GMatrix *im)
   m->chunkPtr[m->nChunks] = (CG_UINT)m->nElems;
 
   // Construct permutation vector
-  m->oldToNewPerm = (CG_UINT *)allocate(ARRAY_ALIGNMENT, m->nr * sizeof(CG_UINT));
+  m->oldToNewPerm = (CG_UINT *)allocate(ARRAY_ALIGNMENT, nr * sizeof(CG_UINT));
   for (int i = 0; i < m->nrPadded; ++i) {
     CG_UINT oldRow = elemsPerRow[i].index;
-    if (oldRow < m->nr)
+    if (oldRow < nr)
       m->oldToNewPerm[oldRow] = (CG_UINT)i;
   }
 
   // Construct inverse permutation vector
-  m->newToOldPerm = (CG_UINT *)allocate(ARRAY_ALIGNMENT, m->nr * sizeof(CG_UINT));
-  for (int i = 0; i < m->nr; ++i) {
+  m->newToOldPerm = (CG_UINT *)allocate(ARRAY_ALIGNMENT, nr * sizeof(CG_UINT));
+  for (int i = 0; i < nr; ++i) {
 #ifdef VERBOSE
     // Sanity check for common error
-    if (m->oldToNewPerm[i] >= m->nr) {
+    if (m->oldToNewPerm[i] >= nr) {
       fprintf(stderr,
           "ERROR matrixConvertMMtoSCS: m->oldToNewPerm[%d]=%d"
           " is out of bounds (>%d).\n",
           i,
           m->oldToNewPerm[i],
-          m->nr);
+          nr);
     }
 #endif
     m->newToOldPerm[m->oldToNewPerm[i]] = (CG_UINT)i;
@@ -141,7 +139,7 @@ void convertMatrix(Matrix *m, GMatrix *im)
   m->val    = (CG_FLOAT *)allocate(ARRAY_ALIGNMENT, m->nElems * sizeof(CG_FLOAT));
 
   // Initialize defaults (essential for padded elements)
-  for (int i = 0; i < m->nElems; ++i) {
+  for (CG_UINT i = 0; i < m->nElems; ++i) {
     m->val[i]    = (CG_FLOAT)0.0;
     m->colInd[i] = (CG_UINT)0;
     // TODO: may need to offset when used with MPI
@@ -154,29 +152,29 @@ void convertMatrix(Matrix *m, GMatrix *im)
     rowLocalElemCount[i] = 0;
   }
 
-  for (int i = 0; i < m->nr; i++) {
+  for (int i = 0; i < nr; i++) {
 
     int rowOld = i;
 
-    for (int j = rowPtr[i]; j < rowPtr[i + 1]; j++) {
-      Entry e        = im->entries[j];
+    for (CG_UINT j = rowPtr[i]; j < rowPtr[i + 1]; j++) {
+      Entry e            = im->entries[j];
 
-      int row        = m->oldToNewPerm[rowOld];
-      int chunkIdx   = row / m->C;
-      int chunkStart = m->chunkPtr[chunkIdx];
-      int chunkRow   = row % m->C;
-      int idx        = chunkStart + rowLocalElemCount[row] * m->C + chunkRow;
+      int row            = m->oldToNewPerm[rowOld];
+      int chunkIdx       = row / m->C;
+      CG_UINT chunkStart = m->chunkPtr[chunkIdx];
+      int chunkRow       = row % m->C;
+      CG_UINT idx        = chunkStart + rowLocalElemCount[row] * m->C + chunkRow;
 
       m->colInd[idx] = (CG_UINT)e.col;
 #ifdef VERBOSE
       // Sanity check for common error
-      if (m->colInd[idx] >= m->nc) {
+      if (m->colInd[idx] >= sm->nc) {
         fprintf(stderr,
             "ERROR matrixConvertMMtoSCS: m->colInd[%d]=%d"
             " is out of bounds (>%d).\n",
             idx,
             m->colInd[idx],
-            m->nc);
+            sm->nc);
       }
 #endif
       m->val[idx] = (CG_FLOAT)e.val;
@@ -186,35 +184,147 @@ void convertMatrix(Matrix *m, GMatrix *im)
 
   free(elemsPerRow);
   free(rowLocalElemCount);
+  free(im->entries);
+  free(im->rowPtr);
+  im->entries = NULL;
+  im->rowPtr  = NULL;
+}
+
+static void writeSCS(Matrix *sm, FILE *fp)
+{
+  SCSMatrix *m = &sm->scs;
+
+  FWRITE(m->chunkPtr, sizeof(CG_UINT), m->nChunks + 1, fp);
+  FWRITE(m->chunkLens, sizeof(CG_UINT), m->nChunks, fp);
+  FWRITE(m->oldToNewPerm, sizeof(CG_UINT), sm->nr, fp);
+  FWRITE(m->newToOldPerm, sizeof(CG_UINT), sm->nr, fp);
+  FWRITE(m->colInd, sizeof(CG_UINT), m->nElems, fp);
+  FWRITE(m->val, sizeof(CG_FLOAT), m->nElems, fp);
+}
+
+static void readSCS(Matrix *sm, FILE *fp)
+{
+  SCSMatrix *m    = &sm->scs;
+
+  m->chunkLens    = (CG_UINT *)allocate(ARRAY_ALIGNMENT, m->nChunks * sizeof(CG_UINT));
+  m->chunkPtr     = (CG_UINT *)allocate(
+      ARRAY_ALIGNMENT, (m->nChunks + 1) * sizeof(CG_UINT));
+  m->oldToNewPerm = (CG_UINT *)allocate(ARRAY_ALIGNMENT, sm->nr * sizeof(CG_UINT));
+  m->newToOldPerm = (CG_UINT *)allocate(ARRAY_ALIGNMENT, sm->nr * sizeof(CG_UINT));
+  m->colInd       = (CG_UINT *)allocate(ARRAY_ALIGNMENT, m->nElems * sizeof(CG_UINT));
+  m->val          = (CG_FLOAT *)allocate(ARRAY_ALIGNMENT, m->nElems * sizeof(CG_FLOAT));
+  FREAD(m->chunkPtr, sizeof(CG_UINT), m->nChunks + 1, fp);
+  FREAD(m->chunkLens, sizeof(CG_UINT), m->nChunks, fp);
+  FREAD(m->oldToNewPerm, sizeof(CG_UINT), sm->nr, fp);
+  FREAD(m->newToOldPerm, sizeof(CG_UINT), sm->nr, fp);
+  FREAD(m->colInd, sizeof(CG_UINT), m->nElems, fp);
+  FREAD(m->val, sizeof(CG_FLOAT), m->nElems, fp);
 }
 
-void spMVM(Matrix *m, const CG_FLOAT *restrict x, CG_FLOAT *restrict y)
+static void freeSCS(Matrix *sm)
 {
-  CG_UINT *colInd    = m->colInd;
-  CG_FLOAT *val      = m->val;
-
-  CG_UINT numChunks  = m->nChunks;
-  CG_UINT C          = m->C;
-  CG_UINT *chunkPtr  = m->chunkPtr;
-  CG_UINT *chunkLens = m->chunkLens;
-
-#pragma omp parallel for schedule(OMP_SCHEDULE)
-  for (int i = 0; i < numChunks; ++i) {
-    CG_FLOAT tmp[C];
-    for (int j = 0; j < C; ++j) {
-      tmp[j] = 0.0;
+  SCSMatrix *m = &sm->scs;
+
+  free(m->chunkPtr);
+  free(m->chunkLens);
+  free(m->oldToNewPerm);
+  free(m->newToOldPerm);
+  free(m->colInd);
+  free(m->val);
+}
+
+/**
+ * @brief Row lengths of the SCS matrix in the original row order.
+ *
+ * Row i is stored in lane oldToNewPerm[i] % C of its chunk, its entries come
+ * first and the padding of the chunk follows. Padding elements hold zero
+ * values, so explicit zeros of the matrix are not counted; the generated
+ * matrices have none.
+ *
+ * @param sm SCS matrix
+ * @param nr Number of local rows
+ * @param len Row lengths, at least nr elements
+ */
+void scsRowLengths(SCSMatrix *sm, CG_UINT nr, CG_FLOAT *len)
+{
+  for (CG_UINT i = 0; i < nr; i++) {
+    CG_UINT row   = sm->oldToNewPerm[i];
+    CG_UINT chunk = row / sm->C;
+    CG_UINT lane  = sm->chunkPtr[chunk] + row % sm->C;
+
+    len[i] = 0.0;
+    for (CG_UINT k = 0; k < sm->chunkLens[chunk]; k++) {
+      len[i] += sm->val[lane + k * sm->C] != 0.0;
     }
+  }
+}
+
+void spMVMSCS(Matrix *m, const CG_FLOAT *restrict x, CG_FLOAT *restrict y)
+{
+  CG_UINT *colInd    = m->scs.colInd;
+  CG_FLOAT *val      = m->scs.val;
+
+  CG_UINT numRows    = m->nr;
+  CG_UINT numChunks  = m->scs.nChunks;
+  CG_UINT C          = m->scs.C;
+  CG_UINT *chunkPtr  = m->scs.chunkPtr;
+  CG_UINT *chunkLens = m->scs.chunkLens;
+
+#pragma omp parallel
+  {
+    THREAD_TIMER_START;
+
+#pragma omp for schedule(OMP_SCHEDULE) nowait
+    for (int i = 0; i < numChunks; ++i) {
+      CG_FLOAT tmp[C];
+      for (int j = 0; j < C; ++j) {
+        tmp[j] = 0.0;
+      }
 
-    int chunkOffset = chunkPtr[i];
-    for (int j = 0; j < chunkLens[i]; ++j) {
-      // NOTE: SIMD should be applied here
-      for (int k = 0; k < C; ++k) {
-        tmp[k] += val[chunkOffset + j * C + k] * x[colInd[chunkOffset + j * C + k]];
+      CG_UINT chunkOffset = chunkPtr[i];
+      for (int j = 0; j < chunkLens[i]; ++j) {
+        // NOTE: SIMD should be applied here
+        for (int k = 0; k < C; ++k) {
+          tmp[k] += val[chunkOffset + j * C + k] * x[colInd[chunkOffset + j * C + k]];
+        }
       }
-    }
 
-    for (int j = 0; j < C; ++j) {
-      y[i * C + j] = tmp[j];
+      // The last chunk may be padded beyond the number of rows
+      CG_UINT rows = MIN(C, numRows - i * C);
+      for (int j = 0; j < rows; ++j) {
+        y[i * C + j] = tmp[j];
+      }
+      // Padding elements are processed like non zeros
+      THREAD_TIMER_WORK(chunkLens[i] * C);
     }
+
+    THREAD_TIMER_STOP(RegionSpMVM);
   }
 }
+
+// Padding elements and the row permutations are part of the footprint
+static size_t bytesSCS(Matrix *m)
+{
+  return (size_t)m->scs.nElems * (sizeof(CG_FLOAT) + sizeof(CG_UINT)) +
+         (2 * m->scs.nChunks + 1) * sizeof(CG_UINT) + 2 * (size_t)m->nr * sizeof(CG_UINT);
+}
+
+// Values and column indices including padding elements, chunk pointers and
+// chunk lengths are streamed once. Padding elements also load x.
+static size_t trafficSCS(Matrix *m, double xReuse)
+{
+  size_t matrix = (size_t)m->scs.nElems * (sizeof(CG_FLOAT) + sizeof(CG_UINT)) +
+                  (2 * m->scs.nChunks + 1) * sizeof(CG_UINT);
+
+  return matrix + spMVMVectorTraffic(m->nr, m->nc, m->scs.nElems, xReuse);
+}
+
+const MatrixFormat SCSFormat = {
+  .name    = "SCS",
+  .convert = convertSCS,
+  .write   = writeSCS,
+  .read    = readSCS,
+  .free    = freeSCS,
+  .bytes   = bytesSCS,
+  .traffic = trafficSCS,
+};
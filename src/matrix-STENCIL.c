@@ -0,0 +1,328 @@
+/* Copyright (C) NHR@FAU, University Erlangen-Nuremberg.
+ * All rights reserved. This file is part of SparseBench.
+ * Use of this source code is governed by a MIT style
+ * license that can be found in the LICENSE file. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "allocate.h"
+#include "matrix.h"
+#include "profiler.h"
+#include "solver.h"
+#include "timing.h"
+
+/**
+ * @brief Set the grid of the stencil operator from the parameters.
+ *
+ * @param sm Stencil operator of the benchmarked matrix
+ * @param p Parameters with the generated matrix and its grid
+ * @return false if the matrix is not generated
+ */
+bool stencilInit(StencilMatrix *sm, Parameter *p)
+{
+  if (strcmp(p->filename, "generate") == 0) {
+    sm->points = 27;
+  } else if (strcmp(p->filename, "generate7P") == 0) {
+    sm->points = 7;
+  } else {
+    return false;
+  }
+
+  sm->nx = p->nx;
+  sm->ny = p->ny;
+  sm->nz = p->nz;
+
+  return true;
+}
+
+static bool inStencil(StencilMatrix *sm, int ix, int iy, int iz, int sx, int sy, int sz)
+{
+  if (ix + sx < 0 || ix + sx >= sm->nx || iy + sy < 0 || iy + sy >= sm->ny) {
+    return false;
+  }
+  if ((iz + sz < 0 && !sm->haloBelow) || (iz + sz >= sm->nz && !sm->haloAbove)) {
+    return false;
+  }
+
+  return sm->points == 27 || sz * sz + sy * sy + sx * sx <= 1;
+}
+
+/**
+ * @brief Number of non zeros of a local row of the stencil operator.
+ *
+ * @param sm Stencil operator of the benchmarked matrix
+ * @param row Local row
+ * @return Number of stencil points inside the global grid
+ */
+CG_UINT stencilRowLength(StencilMatrix *sm, CG_UINT row)
+{
+  int ix      = row % sm->nx;
+  int iy      = (row / sm->nx) % sm->ny;
+  int iz      = row / ((CG_UINT)sm->nx * sm->ny);
+  CG_UINT len = 0;
+
+  for (int sz = -1; sz <= 1; sz++) {
+    for (int sy = -1; sy <= 1; sy++) {
+      for (int sx = -1; sx <= 1; sx++) {
+        len += inStencil(sm, ix, iy, iz, sx, sy, sz);
+      }
+    }
+  }
+
+  return len;
+}
+
+static void allocateStencil(StencilMatrix *sm)
+{
+  size_t plane = (size_t)sm->nx * sm->ny;
+
+  sm->below    = (CG_UINT *)allocate(ARRAY_ALIGNMENT, plane * sizeof(CG_UINT));
+  sm->above    = (CG_UINT *)allocate(ARRAY_ALIGNMENT, plane * sizeof(CG_UINT));
+  sm->xBelow   = (CG_FLOAT *)allocate(ARRAY_ALIGNMENT, plane * sizeof(CG_FLOAT));
+  sm->xAbove   = (CG_FLOAT *)allocate(ARRAY_ALIGNMENT, plane * sizeof(CG_FLOAT));
+}
+
+static void notAStencil(StencilMatrix *sm, CG_UINT row)
+{
+  printf("Row %llu is not part of a generated %d point stencil on a %dx%dx%d grid\n",
+      (unsigned long long)row,
+      sm->points,
+      sm->nx,
+      sm->ny,
+      sm->nz);
+  exit(EXIT_FAILURE);
+}
+
+// The entries of the localized matrix are checked against the generator, which
+// emits the stencil points of a row in the order of the loops below. Halo
+// columns are numbered by commLocalization, they are recorded per point of the
+// plane below and above. Afterwards the matrix is released.
+static void convertSTENCIL(Matrix *m, GMatrix *im)
+{
+  StencilMatrix *sm = &m->stencil;
+  Entry *entries    = im->entries;
+  CG_UINT *rowPtr   = im->rowPtr;
+  CG_UINT plane     = (CG_UINT)sm->nx * sm->ny;
+
+  if (m->nr != plane * sm->nz) {
+    notAStencil(sm, 0);
+  }
+
+  sm->haloBelow = m->startRow > 0;
+  sm->haloAbove = m->stopRow < m->totalNr - 1;
+  allocateStencil(sm);
+
+  for (CG_UINT p = 0; p < plane; p++) {
+    sm->below[p] = CG_UINT_MAX;
+    sm->above[p] = CG_UINT_MAX;
+  }
+
+  for (CG_UINT i = 0; i < m->nr; i++) {
+    int ix    = i % sm->nx;
+    int iy    = (i / sm->nx) % sm->ny;
+    int iz    = i / plane;
+    CG_UINT k = rowPtr[i];
+
+    for (int sz = -1; sz <= 1; sz++) {
+      for (int sy = -1; sy <= 1; sy++) {
+        for (int sx = -1; sx <= 1; sx++) {
+          if (!inStencil(sm, ix, iy, iz, sx, sy, sz)) {
+            continue;
+          }
+          if (k == rowPtr[i + 1]) {
+            notAStencil(sm, i);
+          }
+
+          CG_UINT col = (CG_UINT)entries[k].col;
+          CG_UINT p   = (iy + sy) * sm->nx + ix + sx;
+          int pz      = iz + sz;
+          CG_FLOAT v  = (sx == 0 && sy == 0 && sz == 0) ? 27.0 : -1.0;
+
+          if (pz >= 0 && pz < sm->nz) {
+            if (col != pz * plane + p) {
+              notAStencil(sm, i);
+            }
+          } else {
+            CG_UINT *halo = pz < 0 ? sm->below : sm->above;
+
+            if (halo[p] == CG_UINT_MAX && col >= m->nr) {
+              halo[p] = col;
+            }
+            if (halo[p] != col) {
+              notAStencil(sm, i);
+            }
+          }
+          if (entries[k].val != v) {
+            notAStencil(sm, i);
+          }
+          k++;
+        }
+      }
+    }
+
+    if (k != rowPtr[i + 1]) {
+      notAStencil(sm, i);
+    }
+  }
+
+  free(rowPtr);
+  free(entries);
+  im->rowPtr  = NULL;
+  im->entries = NULL;
+}
+
+static void writeSTENCIL(Matrix *m, FILE *fp)
+{
+  size_t plane = (size_t)m->stencil.nx * m->stencil.ny;
+
+  FWRITE(m->stencil.below, sizeof(CG_UINT), plane, fp);
+  FWRITE(m->stencil.above, sizeof(CG_UINT), plane, fp);
+}
+
+static void readSTENCIL(Matrix *m, FILE *fp)
+{
+  StencilMatrix *sm = &m->stencil;
+  size_t plane      = (size_t)sm->nx * sm->ny;
+
+  allocateStencil(sm);
+  FREAD(sm->below, sizeof(CG_UINT), plane, fp);
+  FREAD(sm->above, sizeof(CG_UINT), plane, fp);
+}
+
+static void freeSTENCIL(Matrix *m)
+{
+  free(m->stencil.below);
+  free(m->stencil.above);
+  free(m->stencil.xBelow);
+  free(m->stencil.xAbove);
+}
+
+static inline void lineSum3(CG_FLOAT *restrict y, const CG_FLOAT *restrict r, int nx)
+{
+  if (nx == 1) {
+    y[0] -= r[0];
+    return;
+  }
+
+  y[0] -= r[0] + r[1];
+  for (int ix = 1; ix < nx - 1; ix++) {
+    y[ix] -= r[ix - 1] + r[ix] + r[ix + 1];
+  }
+  y[nx - 1] -= r[nx - 2] + r[nx - 1];
+}
+
+static inline void lineSum1(CG_FLOAT *restrict y, const CG_FLOAT *restrict r, int nx)
+{
+  for (int ix = 0; ix < nx; ix++) {
+    y[ix] -= r[ix];
+  }
+}
+
+static inline const CG_FLOAT *planeOf(StencilMatrix *sm, const CG_FLOAT *x, int pz)
+{
+  if (pz < 0) {
+    return sm->haloBelow ? sm->xBelow : NULL;
+  }
+  if (pz >= sm->nz) {
+    return sm->haloAbove ? sm->xAbove : NULL;
+  }
+
+  return x + (size_t)pz * sm->nx * sm->ny;
+}
+
+// The diagonal 27 minus all neighbours is 28 times the center minus the sum
+// over all points, so every line of x within the stencil is summed alike
+void spMVMSTENCIL(Matrix *m, const CG_FLOAT *restrict x, CG_FLOAT *restrict y)
+{
+  StencilMatrix *sm = &m->stencil;
+  int nx            = sm->nx;
+  int ny            = sm->ny;
+  int numLines      = ny * sm->nz;
+  int plane         = nx * ny;
+
+#pragma omp parallel
+  {
+    THREAD_TIMER_START;
+
+#pragma omp for schedule(static)
+    for (int p = 0; p < plane; p++) {
+      if (sm->haloBelow) {
+        sm->xBelow[p] = x[sm->below[p]];
+      }
+      if (sm->haloAbove) {
+        sm->xAbove[p] = x[sm->above[p]];
+      }
+    }
+
+#pragma omp for schedule(OMP_SCHEDULE) nowait
+    for (int line = 0; line < numLines; line++) {
+      int iz             = line / ny;
+      int iy             = line % ny;
+      const CG_FLOAT *xc = x + (size_t)line * nx;
+      CG_FLOAT *yl       = y + (size_t)line * nx;
+
+      for (int ix = 0; ix < nx; ix++) {
+        yl[ix] = 28.0 * xc[ix];
+      }
+
+      if (sm->points == 27) {
+        for (int sz = -1; sz <= 1; sz++) {
+          const CG_FLOAT *xp = planeOf(sm, x, iz + sz);
+
+          for (int sy = -1; xp != NULL && sy <= 1; sy++) {
+            if (iy + sy >= 0 && iy + sy < ny) {
+              lineSum3(yl, xp + (iy + sy) * nx, nx);
+            }
+          }
+        }
+      } else {
+        const CG_FLOAT *xb = planeOf(sm, x, iz - 1);
+        const CG_FLOAT *xa = planeOf(sm, x, iz + 1);
+
+        lineSum3(yl, xc, nx);
+        if (iy > 0) {
+          lineSum1(yl, xc - nx, nx);
+        }
+        if (iy < ny - 1) {
+          lineSum1(yl, xc + nx, nx);
+        }
+        if (xb != NULL) {
+          lineSum1(yl, xb + iy * nx, nx);
+        }
+        if (xa != NULL) {
+          lineSum1(yl, xa + iy * nx, nx);
+        }
+      }
+
+      THREAD_TIMER_WORK(nx * sm->points);
+    }
+
+    THREAD_TIMER_STOP(RegionSpMVM);
+  }
+}
+
+// Only the halo maps and the gathered halo planes are stored
+static size_t bytesSTENCIL(Matrix *m)
+{
+  size_t plane = (size_t)m->stencil.nx * m->stencil.ny;
+
+  return 2 * plane * (sizeof(CG_UINT) + sizeof(CG_FLOAT));
+}
+
+// The halo planes are gathered and read once more, x and y are streamed
+static size_t trafficSTENCIL(Matrix *m, double xReuse)
+{
+  return bytesSTENCIL(m) + spMVMVectorTraffic(m->nr, m->nc, m->nnz, xReuse);
+}
+
+const MatrixFormat STENCILFormat = {
+  .name    = "STENCIL",
+  .convert = convertSTENCIL,
+  .write   = writeSTENCIL,
+  .read    = readSTENCIL,
+  .free    = freeSTENCIL,
+  .bytes   = bytesSTENCIL,
+  .traffic = trafficSTENCIL,
+};
@@ -0,0 +1,401 @@
+/* Copyright (C) NHR@FAU, University Erlangen-Nuremberg.
+ * All rights reserved. This file is part of SparseBench.
+ * Use of this source code is governed by a MIT style
+ * license that can be found in the LICENSE file. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "allocate.h"
+#include "matrix.h"
+#include "profiler.h"
+#include "solver.h"
+#include "timing.h"
+
+static void allocatePartitions(SYMMatrix *sm)
+{
+  sm->partPtr    = (CG_UINT *)allocate(ARRAY_ALIGNMENT,
+      (sm->nParts + 1) * sizeof(CG_UINT));
+  sm->reach      = (CG_UINT *)allocate(ARRAY_ALIGNMENT, sm->nParts * sizeof(CG_UINT));
+  sm->partialPtr = (CG_UINT *)allocate(ARRAY_ALIGNMENT,
+      (sm->nParts + 1) * sizeof(CG_UINT));
+}
+
+static void allocatePartial(SYMMatrix *sm)
+{
+  sm->partial = (CG_FLOAT *)allocate(ARRAY_ALIGNMENT,
+      MAX(sm->partialPtr[sm->nParts], 1) * sizeof(CG_FLOAT));
+}
+
+// One partition per thread with about the same number of stored entries. A
+// partition reaches up to the largest local column of its rows.
+static void partitionSYM(SYMMatrix *sm, CG_UINT nr)
+{
+  CG_UINT stored = sm->rowPtr[nr];
+  CG_UINT row    = 0;
+
+  sm->nParts     = 1;
+#ifdef _OPENMP
+  sm->nParts = omp_get_max_threads();
+#endif
+  sm->nParts = MAX(MIN(sm->nParts, (int)nr), 1);
+  allocatePartitions(sm);
+
+  sm->partPtr[0] = 0;
+  for (int t = 1; t < sm->nParts; t++) {
+    size_t target = (size_t)stored * t / sm->nParts;
+
+    while (row < nr && sm->rowPtr[row] < target) {
+      row++;
+    }
+    sm->partPtr[t] = row;
+  }
+  sm->partPtr[sm->nParts] = nr;
+
+  sm->partialPtr[0]       = 0;
+  for (int t = 0; t < sm->nParts; t++) {
+    CG_UINT last  = sm->partPtr[t + 1];
+    CG_UINT reach = last;
+
+    for (CG_UINT j = sm->rowPtr[sm->partPtr[t]]; j < sm->rowPtr[last]; j++) {
+      if (sm->colInd[j] < nr) {
+        reach = MAX(reach, sm->colInd[j] + 1);
+      }
+    }
+
+    sm->reach[t]          = reach;
+    sm->partialPtr[t + 1] = sm->partialPtr[t] + reach - last;
+  }
+
+  allocatePartial(sm);
+}
+
+static CG_UINT countLower(GMatrix *m)
+{
+  CG_UINT lower = 0;
+
+  for (CG_UINT i = 0; i < m->nr; i++) {
+    for (CG_UINT j = m->rowPtr[i]; j < m->rowPtr[i + 1]; j++) {
+      CG_UINT col = (CG_UINT)m->entries[j].col;
+
+      lower += col < m->nr && col < i;
+    }
+  }
+
+  return lower;
+}
+
+// Local columns keep the global column order during the localization, so the
+// local entries of a row form one sorted range [start[i], end[i]) between the
+// halo entries
+static void localRanges(GMatrix *m, CG_UINT *start, CG_UINT *end)
+{
+  for (CG_UINT i = 0; i < m->nr; i++) {
+    start[i] = m->rowPtr[i];
+    end[i]   = m->rowPtr[i];
+
+    for (CG_UINT j = m->rowPtr[i]; j < m->rowPtr[i + 1]; j++) {
+      if (m->entries[j].col < m->nr) {
+        if (start[i] == end[i]) {
+          start[i] = j;
+        }
+        end[i] = j + 1;
+      }
+    }
+  }
+}
+
+// Binary search for a local column in a sorted range of entries
+static bool findEntry(
+    const Entry *entries, CG_UINT lo, CG_UINT hi, CG_GINT col, CG_FLOAT *val)
+{
+  CG_UINT last = hi;
+
+  while (lo < hi) {
+    CG_UINT mid = lo + (hi - lo) / 2;
+
+    if (entries[mid].col < col) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+
+  if (lo == last || entries[lo].col != col) {
+    return false;
+  }
+
+  *val = entries[lo].val;
+  return true;
+}
+
+/**
+ * @brief Check the local block of a localized matrix for the SYM format.
+ *
+ * Every entry (i,j) of the local block needs an entry (j,i) with the same
+ * value, which is found by a binary search in the local range of row j.
+ * Halo columns are not checked.
+ *
+ * @param m Localized matrix
+ * @return true if SYM can store the matrix
+ */
+bool matrixLocalSymmetric(GMatrix *m)
+{
+  CG_UINT nr     = m->nr;
+  CG_UINT *start = (CG_UINT *)allocate(ARRAY_ALIGNMENT, MAX(nr, 1) * sizeof(CG_UINT));
+  CG_UINT *end   = (CG_UINT *)allocate(ARRAY_ALIGNMENT, MAX(nr, 1) * sizeof(CG_UINT));
+  bool symmetric = true;
+
+  localRanges(m, start, end);
+
+  for (CG_UINT i = 0; i < nr && symmetric; i++) {
+    for (CG_UINT j = start[i]; j < end[i] && symmetric; j++) {
+      CG_GINT col = m->entries[j].col;
+      CG_FLOAT val;
+
+      if (col >= nr || col == i) {
+        continue;
+      }
+      symmetric = findEntry(m->entries, start[col], end[col], i, &val) &&
+                  val == m->entries[j].val;
+    }
+  }
+
+  free(start);
+  free(end);
+  return symmetric;
+}
+
+// Entries below the diagonal of the local block are dropped while the values
+// are compacted in place into the entry array of im
+static void convertSYM(Matrix *m, GMatrix *im)
+{
+  SYMMatrix *sm   = &m->sym;
+  Entry *entries  = im->entries;
+  CG_UINT *rowPtr = im->rowPtr;
+  CG_UINT nr      = m->nr;
+
+  if (!matrixLocalSymmetric(im)) {
+    printf("The SYM format needs a symmetric matrix\n");
+    exit(EXIT_FAILURE);
+  }
+
+  CG_UINT lower  = countLower(im);
+  CG_UINT stored = rowPtr[nr] - lower;
+  CG_UINT start  = 0;
+  CG_UINT k      = 0;
+  sm->colInd     = (CG_UINT *)allocate(ARRAY_ALIGNMENT, MAX(stored, 1) * sizeof(CG_UINT));
+
+  for (CG_UINT i = 0; i < nr; i++) {
+    CG_UINT end = rowPtr[i + 1];
+
+    for (CG_UINT j = start; j < end; j++) {
+      CG_UINT col  = (CG_UINT)entries[j].col;
+      CG_FLOAT val = entries[j].val;
+
+      if (col < nr && col < i) {
+        continue;
+      }
+
+      sm->colInd[k] = col;
+      memcpy((CG_FLOAT *)entries + k, &val, sizeof(CG_FLOAT));
+      k++;
+    }
+
+    rowPtr[i + 1] = k;
+    start         = end;
+  }
+
+  sm->rowPtr  = rowPtr;
+  sm->val     = (CG_FLOAT *)reallocate(entries,
+      ARRAY_ALIGNMENT,
+      MAX(stored, 1) * sizeof(CG_FLOAT),
+      im->nnz * sizeof(Entry));
+  im->rowPtr  = NULL;
+  im->entries = NULL;
+
+  partitionSYM(sm, nr);
+}
+
+static void writeSYM(Matrix *m, FILE *fp)
+{
+  SYMMatrix *sm  = &m->sym;
+  CG_UINT stored = sm->rowPtr[m->nr];
+
+  FWRITE(sm->rowPtr, sizeof(CG_UINT), m->nr + 1, fp);
+  FWRITE(sm->colInd, sizeof(CG_UINT), stored, fp);
+  FWRITE(sm->val, sizeof(CG_FLOAT), stored, fp);
+  FWRITE(sm->partPtr, sizeof(CG_UINT), sm->nParts + 1, fp);
+  FWRITE(sm->reach, sizeof(CG_UINT), sm->nParts, fp);
+  FWRITE(sm->partialPtr, sizeof(CG_UINT), sm->nParts + 1, fp);
+}
+
+static void readSYM(Matrix *m, FILE *fp)
+{
+  SYMMatrix *sm = &m->sym;
+
+  sm->rowPtr    = (CG_UINT *)allocate(ARRAY_ALIGNMENT, (m->nr + 1) * sizeof(CG_UINT));
+  FREAD(sm->rowPtr, sizeof(CG_UINT), m->nr + 1, fp);
+
+  CG_UINT stored = sm->rowPtr[m->nr];
+  sm->colInd     = (CG_UINT *)allocate(ARRAY_ALIGNMENT, MAX(stored, 1) * sizeof(CG_UINT));
+  sm->val        = (CG_FLOAT *)allocate(ARRAY_ALIGNMENT,
+      MAX(stored, 1) * sizeof(CG_FLOAT));
+  FREAD(sm->colInd, sizeof(CG_UINT), stored, fp);
+  FREAD(sm->val, sizeof(CG_FLOAT), stored, fp);
+
+  allocatePartitions(sm);
+  FREAD(sm->partPtr, sizeof(CG_UINT), sm->nParts + 1, fp);
+  FREAD(sm->reach, sizeof(CG_UINT), sm->nParts, fp);
+  FREAD(sm->partialPtr, sizeof(CG_UINT), sm->nParts + 1, fp);
+  allocatePartial(sm);
+}
+
+static void freeSYM(Matrix *m)
+{
+  free(m->sym.rowPtr);
+  free(m->sym.colInd);
+  free(m->sym.val);
+  free(m->sym.partPtr);
+  free(m->sym.reach);
+  free(m->sym.partialPtr);
+  free(m->sym.partial);
+}
+
+/**
+ * @brief Full row lengths of the symmetric matrix.
+ *
+ * @param sm Symmetric matrix
+ * @param nr Number of local rows
+ * @param len Row lengths, at least nr elements
+ */
+void symRowLengths(SYMMatrix *sm, CG_UINT nr, CG_FLOAT *len)
+{
+  for (CG_UINT i = 0; i < nr; i++) {
+    len[i] = 0.0;
+  }
+
+  for (CG_UINT i = 0; i < nr; i++) {
+    for (CG_UINT j = sm->rowPtr[i]; j < sm->rowPtr[i + 1]; j++) {
+      CG_UINT col = sm->colInd[j];
+
+      len[i] += 1.0;
+      if (col > i && col < nr) {
+        len[col] += 1.0;
+      }
+    }
+  }
+}
+
+// Every thread computes whole partitions, a partition writes the rows it owns
+// directly and the rows behind it into its range of partial. After a barrier
+// the partial results are added to the rows they belong to. The partitions
+// are fixed at conversion, so OMP_SCHEDULE does not apply.
+void spMVMSYM(Matrix *m, const CG_FLOAT *restrict x, CG_FLOAT *restrict y)
+{
+  CG_UINT *colInd     = m->sym.colInd;
+  CG_FLOAT *val       = m->sym.val;
+
+  CG_UINT numRows     = m->nr;
+  CG_UINT *rowPtr     = m->sym.rowPtr;
+  int nParts          = m->sym.nParts;
+  CG_UINT *partPtr    = m->sym.partPtr;
+  CG_UINT *reach      = m->sym.reach;
+  CG_UINT *partialPtr = m->sym.partialPtr;
+  CG_FLOAT *partial   = m->sym.partial;
+
+#pragma omp parallel
+  {
+    THREAD_TIMER_START;
+    int thread     = 0;
+    int numThreads = 1;
+#ifdef _OPENMP
+    thread     = omp_get_thread_num();
+    numThreads = omp_get_num_threads();
+#endif
+
+    for (int t = thread; t < nParts; t += numThreads) {
+      CG_UINT first   = partPtr[t];
+      CG_UINT last    = partPtr[t + 1];
+      CG_FLOAT *ahead = partial + partialPtr[t];
+
+      for (CG_UINT i = first; i < last; i++) {
+        y[i] = 0.0;
+      }
+      for (CG_UINT i = 0; i < reach[t] - last; i++) {
+        ahead[i] = 0.0;
+      }
+
+      for (CG_UINT i = first; i < last; i++) {
+        CG_FLOAT xi  = x[i];
+        CG_FLOAT sum = 0.0;
+
+        for (CG_UINT j = rowPtr[i]; j < rowPtr[i + 1]; j++) {
+          CG_UINT col = colInd[j];
+
+          sum += val[j] * x[col];
+          // transposed contribution, halo columns are stored on both ranks
+          if (col > i && col < last) {
+            y[col] += val[j] * xi;
+          } else if (col >= last && col < numRows) {
+            ahead[col - last] += val[j] * xi;
+          }
+        }
+
+        y[i] += sum;
+      }
+
+      THREAD_TIMER_WORK(rowPtr[last] - rowPtr[first]);
+    }
+
+#pragma omp barrier
+
+#pragma omp for schedule(static) nowait
+    for (int i = 0; i < numRows; i++) {
+      for (int t = 0; t < nParts && partPtr[t + 1] <= i; t++) {
+        if (i < reach[t]) {
+          y[i] += partial[partialPtr[t] + i - partPtr[t + 1]];
+        }
+      }
+    }
+
+    THREAD_TIMER_STOP(RegionSpMVM);
+  }
+}
+
+static size_t bytesSYM(Matrix *m)
+{
+  SYMMatrix *sm = &m->sym;
+
+  return (size_t)sm->rowPtr[m->nr] * (sizeof(CG_FLOAT) + sizeof(CG_UINT)) +
+         (m->nr + 1 + 3 * (size_t)sm->nParts + 2) * sizeof(CG_UINT) +
+         MAX(sm->partialPtr[sm->nParts], 1) * sizeof(CG_FLOAT);
+}
+
+// The stored triangle and the row pointers are streamed once, the partial
+// results are written and read again, y is updated once more in the reduction
+static size_t trafficSYM(Matrix *m, double xReuse)
+{
+  SYMMatrix *sm  = &m->sym;
+  CG_UINT stored = sm->rowPtr[m->nr];
+
+  return (size_t)stored * (sizeof(CG_FLOAT) + sizeof(CG_UINT)) +
+         (m->nr + 1) * sizeof(CG_UINT) +
+         2 * (size_t)sm->partialPtr[sm->nParts] * sizeof(CG_FLOAT) +
+         m->nr * sizeof(CG_FLOAT) + spMVMVectorTraffic(m->nr, m->nc, stored, xReuse);
+}
+
+const MatrixFormat SYMFormat = {
+  .name    = "SYM",
+  .convert = convertSYM,
+  .write   = writeSYM,
+  .read    = readSYM,
+  .free    = freeSYM,
+  .bytes   = bytesSYM,
+  .traffic = trafficSYM,
+};
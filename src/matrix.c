@@ -4,6 +4,7 @@
  * license that can be found in the LICENSE file. */
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 
 #include "allocate.h"
@@ -30,14 +31,14 @@ static inline int compareRow(const void *a, const void *b)
 void matrixGenerate(GMatrix *m, Parameter *p, int rank, int size, bool use_7pt_stencil)
 {
 
-  CG_UINT local_nrow = p->nx * p->ny * p->nz;
+  CG_UINT local_nrow = (CG_UINT)p->nx * p->ny * p->nz;
   CG_UINT local_nnz  = 27 * local_nrow;
 
-  CG_UINT total_nrow = local_nrow * size;
-  CG_UINT total_nnz  = 27 * total_nrow;
+  CG_GINT total_nrow = (CG_GINT)local_nrow * size;
+  CG_GINT total_nnz  = 27 * total_nrow;
 
-  int start_row      = local_nrow * rank;
-  int stop_row       = start_row + local_nrow - 1;
+  CG_GINT start_row  = (CG_GINT)local_nrow * rank;
+  CG_GINT stop_row   = start_row + local_nrow - 1;
 
   if (!rank) {
     if (use_7pt_stencil) {
@@ -52,7 +53,7 @@ void matrixGenerate(GMatrix *m, Parameter *p, int rank, int size, bool use_7pt_s
   m->rowPtr  = (CG_UINT *)allocate(ARRAY_ALIGNMENT, (local_nrow + 1) * sizeof(CG_UINT));
 
   CG_UINT *currowptr = m->rowPtr;
-  CG_UINT nnzglobal  = 0;
+  CG_GINT nnzglobal  = 0;
   int nx = p->nx, ny = p->ny, nz = p->nz;
   CG_UINT cursor = 0;
 
@@ -62,14 +63,14 @@ void matrixGenerate(GMatrix *m, Parameter *p, int rank, int size, bool use_7pt_s
     for (int iy = 0; iy < ny; iy++) {
       for (int ix = 0; ix < nx; ix++) {
 
-        int currow = start_row + iz * nx * ny + iy * nx + ix;
-        int nnzrow = 0;
+        CG_GINT currow = start_row + (CG_GINT)iz * nx * ny + iy * nx + ix;
+        int nnzrow     = 0;
 
         for (int sz = -1; sz <= 1; sz++) {
           for (int sy = -1; sy <= 1; sy++) {
             for (int sx = -1; sx <= 1; sx++) {
 
-              int curcol = currow + sz * nx * ny + sy * nx + sx;
+              CG_GINT curcol = currow + (CG_GINT)sz * nx * ny + sy * nx + sx;
               // Since we have a stack of nx by ny by nz domains
               //, stacking in the z direction, we check to see
               // if sx and sy are reaching outside of the domain,
@@ -102,9 +103,9 @@ void matrixGenerate(GMatrix *m, Parameter *p, int rank, int size, bool use_7pt_s
   } // end iz loop
 
 #ifdef VERBOSE
-  printf("Process %d of %d has %d rows\n", rank, size, local_nrow);
-  printf("Global rows %d through %d\n", start_row, stop_row);
-  printf("%d nonzeros\n", local_nnz);
+  printf("Process %d of %d has %llu rows\n", rank, size, (unsigned long long)local_nrow);
+  printf("Global rows %lld through %lld\n", start_row, stop_row);
+  printf("%llu nonzeros\n", (unsigned long long)local_nnz);
 #endif
 
   m->startRow = start_row;
@@ -120,7 +121,7 @@ void MMMatrixRead(MMMatrix *m, char *filename)
 {
   MM_typecode matcode;
   FILE *f = NULL;
-  int M, N, nz;
+  long long M, N, nz;
 
   if ((f = fopen(filename, "r")) == NULL) {
     printf("Unable to open file.\n");
@@ -164,11 +165,11 @@ void MMMatrixRead(MMMatrix *m, char *filename)
     exit(EXIT_FAILURE);
   }
 
-  if (mm_read_mtx_crd_size(f, &M, &N, &nz) != 0) {
+  if (mm_read_mtx_crd_size_ll(f, &M, &N, &nz) != 0) {
     exit(EXIT_FAILURE);
   }
 
-  printf("Read matrix %s with %d non zeroes and %d rows\n", filename, nz, M);
+  printf("Read matrix %s with %lld non zeroes and %lld rows\n", filename, nz, M);
 
   if (sym_flag) {
     m->entries = (MMEntry *)allocate(ARRAY_ALIGNMENT, nz * 2 * sizeof(MMEntry));
@@ -177,19 +178,19 @@ void MMMatrixRead(MMMatrix *m, char *filename)
   }
 
   size_t cursor = 0;
-  int row, col;
+  long long row, col;
   double v;
   MMEntry *entries = m->entries;
 
   for (size_t i = 0; i < nz; i++) {
 
     if (pattern_flag) {
-      fscanf(f, "%d %d\n", &row, &col);
+      fscanf(f, "%lld %lld\n", &row, &col);
       v = 1.;
     } else if (complex_flag) {
-      fscanf(f, "%d %d %lg %*g\n", &row, &col, &v);
+      fscanf(f, "%lld %lld %lg %*g\n", &row, &col, &v);
     } else {
-      fscanf(f, "%d %d %lg\n", &row, &col, &v);
+      fscanf(f, "%lld %lld %lg\n", &row, &col, &v);
     }
 
     row--; /* adjust from 1-based to 0-based */
@@ -223,41 +224,165 @@ void MMMatrixRead(MMMatrix *m, char *filename)
 #endif
 }
 
+/**
+ * @brief Convert the local part of a Matrix Market matrix into a GMatrix.
+ *
+ * The entries are sorted by row. They are compacted in place into the smaller
+ * GMatrix entries, the GMatrix takes over the entry array of mm and mm is left
+ * without entries.
+ *
+ * @param mm Local matrix part, consumed
+ * @param[out] m Matrix to fill
+ */
 void matrixConvertfromMM(MMMatrix *mm, GMatrix *m)
 {
-  m->startRow     = mm->startRow;
-  m->stopRow      = mm->stopRow;
-  m->totalNr      = mm->totalNr;
-  m->totalNnz     = mm->totalNnz;
-  m->nr           = mm->nr;
-  m->nc           = mm->nr;
-  m->nnz          = mm->nnz;
-  m->entries      = (Entry *)allocate(ARRAY_ALIGNMENT, m->nnz * sizeof(Entry));
-  m->rowPtr       = (CG_UINT *)allocate(ARRAY_ALIGNMENT, (m->nr + 1) * sizeof(CG_UINT));
-
-  int *valsPerRow = (int *)allocate(ARRAY_ALIGNMENT, m->nr * sizeof(int));
-
-  for (int i = 0; i < m->nr; i++) {
-    valsPerRow[i] = 0;
-  }
+  _Static_assert(
+      sizeof(Entry) <= sizeof(MMEntry), "in place conversion needs smaller entries");
+
+  m->startRow      = mm->startRow;
+  m->stopRow       = mm->stopRow;
+  m->totalNr       = mm->totalNr;
+  m->totalNnz      = mm->totalNnz;
+  m->nr            = mm->nr;
+  m->nc            = mm->nr;
+  m->nnz           = mm->nnz;
+  m->rowPtr        = (CG_UINT *)allocate(ARRAY_ALIGNMENT, (m->nr + 1) * sizeof(CG_UINT));
 
   MMEntry *entries = mm->entries;
-  int startRow     = mm->startRow;
+  CG_GINT startRow = mm->startRow;
+
+  for (CG_UINT i = 0; i <= m->nr; i++) {
+    m->rowPtr[i] = 0;
+  }
+  for (size_t i = 0; i < mm->count; i++) {
+    m->rowPtr[entries[i].row - startRow + 1]++;
+  }
+  for (CG_UINT i = 0; i < m->nr; i++) {
+    m->rowPtr[i + 1] += m->rowPtr[i];
+  }
 
-  for (int i = 0; i < mm->count; i++) {
-    valsPerRow[entries[i].row - startRow]++;
+  // Entry i never overlaps MMEntry j > i, so a forward pass can overwrite the
+  // array it reads. memcpy keeps the compiler from reordering the accesses.
+  for (size_t i = 0; i < mm->count; i++) {
+    Entry e = { entries[i].col, (CG_FLOAT)entries[i].val };
+
+    memcpy((Entry *)entries + i, &e, sizeof(Entry));
   }
 
-  m->rowPtr[0] = 0;
+  m->entries  = (Entry *)reallocate(entries,
+      ARRAY_ALIGNMENT,
+      mm->count * sizeof(Entry),
+      mm->count * sizeof(MMEntry));
+  mm->entries = NULL;
+  mm->count   = 0;
+}
 
-  // convert to CCRS format
-  for (int rowID = 0; rowID < m->nr; rowID++) {
-    m->rowPtr[rowID + 1] = m->rowPtr[rowID] + valsPerRow[rowID];
+/**
+ * @brief Vector part of the spMVM traffic model.
+ *
+ * y is written once. x is read either once per element (xReuse = 0), which is
+ * the lower bound for perfect cache reuse, or xReuse times per stored matrix
+ * element as measured for a given matrix and cache size. Write allocate
+ * transfers of y are not included.
+ *
+ * @param nr Number of local rows
+ * @param nc Number of local columns including externals
+ * @param nElems Number of stored matrix elements including padding
+ * @param xReuse x elements loaded per stored matrix element
+ * @return Bytes of vector traffic of one spMVM call
+ */
+size_t spMVMVectorTraffic(CG_UINT nr, CG_UINT nc, CG_UINT nElems, double xReuse)
+{
+  size_t xTraffic = nc * sizeof(CG_FLOAT);
+
+  if (xReuse > 0.0) {
+    xTraffic = (size_t)(xReuse * nElems * sizeof(CG_FLOAT));
+  }
 
-    // loop over all elements in Row
-    for (int id = m->rowPtr[rowID]; id < m->rowPtr[rowID + 1]; id++) {
-      m->entries[id].val = (CG_FLOAT)entries[id].val;
-      m->entries[id].col = (CG_UINT)entries[id].col;
+  return nr * sizeof(CG_FLOAT) + xTraffic;
+}
+
+static const MatrixFormat *Formats[NUMFORMATS] = { &CRSFormat,
+  &SCSFormat,
+  &CCRSFormat,
+  &CRS16Format,
+  &CRSFFormat,
+  &STENCILFormat,
+  &SYMFormat,
+  &BCSRFormat };
+
+/**
+ * @brief Look up a storage format by its name.
+ *
+ * @param name Format name: CRS, SCS, CCRS, CRS16, CRSF, STENCIL, SYM or BCSR
+ * @return Format, exits for an unknown name
+ */
+FormatType matrixFormat(const char *name)
+{
+  for (int i = 0; i < NUMFORMATS; i++) {
+    if (strcmp(name, Formats[i]->name) == 0) {
+      return (FormatType)i;
     }
   }
+
+  printf("Unknown matrix format %s\n", name);
+  exit(EXIT_FAILURE);
+}
+
+const char *matrixFormatName(FormatType format)
+{
+  return Formats[format]->name;
+}
+
+void convertMatrix(Matrix *m, GMatrix *im)
+{
+  m->startRow  = im->startRow;
+  m->stopRow   = im->stopRow;
+  m->totalNr   = im->totalNr;
+  m->totalNnz  = im->totalNnz;
+  m->nr        = im->nr;
+  m->nc        = im->nc;
+  m->nnz       = im->nnz;
+  m->newToOld  = im->newToOld;
+  im->newToOld = NULL;
+
+  Formats[m->format]->convert(m, im);
+}
+
+void writeMatrix(Matrix *m, FILE *fp)
+{
+  // Pointers in the header are meaningless on read and get replaced
+  FWRITE(m, sizeof(Matrix), 1, fp);
+  Formats[m->format]->write(m, fp);
+  if (m->newToOld != NULL) {
+    FWRITE(m->newToOld, sizeof(CG_UINT), m->nr, fp);
+  }
+}
+
+void readMatrix(Matrix *m, FILE *fp)
+{
+  FREAD(m, sizeof(Matrix), 1, fp);
+  Formats[m->format]->read(m, fp);
+
+  // The stored pointer only tells whether a permutation follows
+  if (m->newToOld != NULL) {
+    m->newToOld = (CG_UINT *)allocate(ARRAY_ALIGNMENT, MAX(m->nr, 1) * sizeof(CG_UINT));
+    FREAD(m->newToOld, sizeof(CG_UINT), m->nr, fp);
+  }
+}
+
+void matrixFree(Matrix *m)
+{
+  Formats[m->format]->free(m);
+  free(m->newToOld);
+}
+
+size_t spMVMTraffic(Matrix *m, double xReuse)
+{
+  return Formats[m->format]->traffic(m, xReuse);
+}
+
+size_t matrixBytes(Matrix *m)
+{
+  return Formats[m->format]->bytes(m);
 }
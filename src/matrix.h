@@ -11,49 +11,117 @@
 #include "parameter.h"
 #include "util.h"
 
-#ifdef CRS
+#include "BCSRMatrix.h"
+#include "CCRSMatrix.h"
+#include "CRS16Matrix.h"
+#include "CRSFMatrix.h"
 #include "CRSMatrix.h"
-#endif
-#ifdef SCS
 #include "SCSMatrix.h"
-#endif
-#ifdef CCRS
-#include "CCRSMatrix.h"
-#endif
+#include "SYMMatrix.h"
+#include "StencilMatrix.h"
+
+typedef enum {
+  FMT_CRS = 0,
+  FMT_SCS,
+  FMT_CCRS,
+  FMT_CRS16,
+  FMT_CRSF,
+  FMT_STENCIL,
+  FMT_SYM,
+  FMT_BCSR,
+  NUMFORMATS
+} FormatType;
+
+// Benchmarked matrix, the storage format is selected at runtime
+typedef struct {
+  FormatType format;
+  CG_UINT nr, nc, nnz; // number of rows, columns and non zeros
+  CG_GINT totalNr, totalNnz; // number of total rows and non zeros
+  CG_GINT startRow, stopRow; // range of rows owned by current rank
+  CG_UINT *newToOld; // original local row of every row, NULL if not reordered
+  union {
+    CRSMatrix crs;
+    SCSMatrix scs;
+    CCRSMatrix ccrs;
+    CRS16Matrix crs16;
+    CRSFMatrix crsf;
+    StencilMatrix stencil;
+    SYMMatrix sym;
+    BCSRMatrix bcsr;
+  };
+} Matrix;
 
 typedef struct {
-  CG_UINT col;
+  CG_GINT col; // global column index, local after commLocalization
   CG_FLOAT val;
 } Entry;
 
 typedef struct {
   CG_UINT nr, nc, nnz; // number of rows, columns and non zeros
-  CG_UINT totalNr, totalNnz; // number of total rows and non zeros
-  CG_UINT startRow, stopRow; // range of rows owned by current rank
+  CG_GINT totalNr, totalNnz; // number of total rows and non zeros
+  CG_GINT startRow, stopRow; // range of rows owned by current rank
   CG_UINT *rowPtr; // row Pointer
   Entry *entries;
+  CG_UINT *newToOld; // original local row of every row, NULL if not reordered
 } GMatrix;
 
 typedef struct {
-  int row;
-  int col;
+  CG_GINT row;
+  CG_GINT col;
   double val;
 } MMEntry;
 
 typedef struct {
   size_t count;
-  int nr, nnz;
-  int totalNr, totalNnz; // number of total rows and non zeros
-  int startRow, stopRow; // range of rows owned by current rank
+  CG_GINT nr, nnz;
+  CG_GINT totalNr, totalNnz; // number of total rows and non zeros
+  CG_GINT startRow, stopRow; // range of rows owned by current rank
   MMEntry *entries;
 } MMMatrix;
 
 extern void MMMatrixRead(MMMatrix *m, char *filename);
 extern void matrixConvertfromMM(MMMatrix *mm, GMatrix *m);
 
+extern bool matrixLocalSymmetric(GMatrix *m);
 extern void matrixGenerate(
     GMatrix *m, Parameter *p, int rank, int size, bool use_7pt_stencil);
 
+// Operations of one storage format. The spMVM kernel is not part of the table,
+// spMVM calls the kernel of the format directly.
+typedef struct {
+  const char *name;
+  // Convert into the format. The arrays of im are released or taken over by m,
+  // im is left without entries.
+  void (*convert)(Matrix *m, GMatrix *im);
+  // Format specific arrays, the header of m is written and read by the caller
+  void (*write)(Matrix *m, FILE *fp);
+  void (*read)(Matrix *m, FILE *fp);
+  void (*free)(Matrix *m);
+  // Memory footprint in bytes of the local matrix part including all index arrays
+  size_t (*bytes)(Matrix *m);
+  // Minimum memory traffic in bytes of one spMVM call, see spMVMTraffic
+  size_t (*traffic)(Matrix *m, double xReuse);
+} MatrixFormat;
+
+extern const MatrixFormat CRSFormat, SCSFormat, CCRSFormat, CRS16Format, CRSFFormat,
+    STENCILFormat, SYMFormat, BCSRFormat;
+
+extern FormatType matrixFormat(const char *name);
+extern const char *matrixFormatName(FormatType format);
+
+// Convert into the format set in m->format. The arrays of im are released or
+// taken over by m, im is left without entries.
 extern void convertMatrix(Matrix *m, GMatrix *im);
+extern void writeMatrix(Matrix *m, FILE *fp);
+extern void readMatrix(Matrix *m, FILE *fp);
+extern void matrixFree(Matrix *m);
+
+// Minimum memory traffic in bytes of one spMVM call on the local matrix part.
+// xReuse is the number of x elements loaded per stored matrix element, 0 means
+// every element of x is loaded exactly once.
+extern size_t spMVMTraffic(Matrix *m, double xReuse);
+// Memory footprint in bytes of the local matrix part including all index arrays
+extern size_t matrixBytes(Matrix *m);
+extern size_t spMVMVectorTraffic(CG_UINT nr, CG_UINT nc, CG_UINT nElems, double xReuse);
 
 #endif // __MATRIX_H_
@@ -3,7 +3,9 @@
  * Use of this source code is governed by a MIT style
  * license that can be found in the LICENSE file. */
 #ifdef _MPI
+#include <stdbool.h>
 #include <stdio.h>
+#include <string.h>
 
 #include "mpi.h"
 
@@ -11,12 +13,11 @@
 #include "matrixBinfile.h"
 #include "util.h"
 
-#define HEADERSIZE 24
-
-static int sizeOfRank(int rank, int size, int N)
-{
-  return N / size + ((N % size > rank) ? 1 : 0);
-}
+typedef struct {
+  MPI_File fh;
+  MPI_Offset offset; // byte offset of the row pointer array
+  bool wide;
+} FileRowPtr;
 
 static void createEntrytype(MPI_Datatype *entryType)
 {
@@ -35,184 +36,154 @@ static void createEntrytype(MPI_Datatype *entryType)
   MPI_Type_commit(entryType);
 }
 
-void matrixBinWrite(GMatrix *m, CommType *c, char *filename)
+// Read count elements at a byte offset in chunks of at most MPI_CHUNK_COUNT
+static void readLarge(
+    MPI_File fh, MPI_Offset offset, void *buf, size_t count, MPI_Datatype type)
 {
-  MPI_File fh;
-
-  if (c->size > 1) {
-    fprintf(stderr, "ERROR: Matrix writing only supported for single rank\n");
-    return;
-  }
-
-  MPI_File_open(
-      MPI_COMM_WORLD, filename, MPI_MODE_WRONLY | MPI_MODE_CREATE, MPI_INFO_NULL, &fh);
-
-  if (commIsMaster(c)) {
-    printf("Writing matrix to %s\n", filename);
-  }
-
-  char header[HEADERSIZE] = "# SparseBench DataFile";
-  MPI_File_set_view(fh, 0, MPI_CHAR, MPI_CHAR, "native", MPI_INFO_NULL);
-
-  if (commIsMaster(c)) {
-    MPI_File_write(fh, header, HEADERSIZE, MPI_CHAR, MPI_STATUS_IGNORE);
+  char *cursor = (char *)buf;
+  MPI_Aint lb, extent;
+  MPI_Status status;
+  MPI_Type_get_extent(type, &lb, &extent);
+
+  while (count > 0) {
+    int n = (int)MIN(count, (size_t)MPI_CHUNK_COUNT);
+    int received;
+    MPI_File_read_at(fh, offset, cursor, n, type, &status);
+    MPI_Get_count(&status, type, &received);
+    if (received != n) {
+      printf("ERROR reading matrix file!\n");
+      MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+    offset += (MPI_Offset)n * extent;
+    cursor += (size_t)n * extent;
+    count -= n;
   }
+}
 
-  MPI_Offset disp;
-  MPI_File_sync(fh);
-  MPI_Barrier(MPI_COMM_WORLD);
-  MPI_File_get_size(fh, &disp);
-  MPI_File_set_view(fh, disp, MPI_UNSIGNED, MPI_UNSIGNED, "native", MPI_INFO_NULL);
-  if (commIsMaster(c)) {
-    // FIXME: convert to unsigned int in case CG_UINT is different
-    MPI_File_write(fh, &m->totalNr, 1, MPI_UNSIGNED, MPI_STATUS_IGNORE);
-    MPI_File_write(fh, &m->totalNnz, 1, MPI_UNSIGNED, MPI_STATUS_IGNORE);
-    MPI_File_write(fh, m->rowPtr, m->totalNr + 1, MPI_UNSIGNED, MPI_STATUS_IGNORE);
-  }
-  MPI_Datatype entryType;
-  createEntrytype(&entryType);
-  MPI_File_sync(fh);
-  MPI_Barrier(MPI_COMM_WORLD);
-  MPI_File_get_size(fh, &disp);
-  MPI_File_set_view(fh, disp, entryType, entryType, "native", MPI_INFO_NULL);
+// Read count row offsets or counts and widen them to 64 bit
+static void readIndices(
+    MPI_File fh, MPI_Offset offset, unsigned long long *buf, size_t count, bool wide)
+{
+  if (wide) {
+    readLarge(fh, offset, buf, count, MPI_UNSIGNED_LONG_LONG);
+  } else {
+    unsigned int *narrow =
+        (unsigned int *)allocate(ARRAY_ALIGNMENT, count * sizeof(unsigned int));
+    readLarge(fh, offset, narrow, count, MPI_UNSIGNED);
 
-  FEntryType *entries =
-      (FEntryType *)allocate(ARRAY_ALIGNMENT, m->totalNnz * sizeof(FEntryType));
+    for (size_t i = 0; i < count; i++) {
+      buf[i] = narrow[i];
+    }
 
-  for (int i = 0; i < m->nnz; i++) {
-    entries[i].col = (unsigned int)m->entries[i].col;
-    entries[i].val = (float)m->entries[i].val;
+    free(narrow);
   }
+}
 
-  if (commIsMaster(c)) {
-    MPI_File_write(fh, entries, m->totalNnz, entryType, MPI_STATUS_IGNORE);
-  }
+// Lookup of a single global row pointer in the file for partitionStartRow
+static CG_GINT fileRowPtr(void *ctx, CG_GINT row)
+{
+  FileRowPtr *f    = (FileRowPtr *)ctx;
+  size_t indexSize = f->wide ? sizeof(unsigned long long) : sizeof(unsigned int);
+  unsigned long long value;
 
-  free(entries);
-  MPI_Type_free(&entryType);
-  MPI_File_close(&fh);
+  readIndices(f->fh, f->offset + row * indexSize, &value, 1, f->wide);
+  return (CG_GINT)value;
 }
 
-void matrixBinRead(GMatrix *m, CommType *c, char *filename)
+void matrixBinRead(GMatrix *m, CommType *c, char *filename, DistributionType type)
 {
   MPI_File fh;
-  MPI_Status status;
-  MPI_Offset offset, disp;
-  int count = 0;
 
-  MPI_File_open(MPI_COMM_WORLD, filename, MPI_MODE_RDONLY, MPI_INFO_NULL, &fh);
+  if (MPI_File_open(MPI_COMM_WORLD, filename, MPI_MODE_RDONLY, MPI_INFO_NULL, &fh) !=
+      MPI_SUCCESS) {
+    commAbort(c, "Could not open binary matrix file");
+  }
 
   if (commIsMaster(c)) {
     printf("Reading matrix from %s\n", filename);
   }
 
-  // read file header
+  // read file header, it determines the width of counts and row offsets
   char header[HEADERSIZE];
-  MPI_File_set_view(fh, 0, MPI_CHAR, MPI_CHAR, "native", MPI_INFO_NULL);
-  MPI_File_read(fh, header, HEADERSIZE, MPI_CHAR, &status);
-  MPI_Get_count(&status, MPI_CHAR, &count);
-  if (count != HEADERSIZE) {
-    printf("ERROR reading header!\n");
-  }
+  bool wide = false;
+  readLarge(fh, 0, header, HEADERSIZE, MPI_CHAR);
 
-  // read total matrix size
-  MPI_File_get_position(fh, &offset);
-  MPI_File_get_byte_offset(fh, offset, &disp);
-  MPI_File_set_view(fh, disp, MPI_UNSIGNED, MPI_UNSIGNED, "native", MPI_INFO_NULL);
-  unsigned int totalNr, totalNnz;
-  MPI_File_read(fh, &totalNr, 1, MPI_UNSIGNED, &status);
-  MPI_Get_count(&status, MPI_UNSIGNED, &count);
-  if (count != 1) {
-    printf("ERROR reading unsigned!\n");
-  }
-  MPI_File_read(fh, &totalNnz, 1, MPI_UNSIGNED, &status);
-  MPI_Get_count(&status, MPI_UNSIGNED, &count);
-  if (count != 1) {
-    printf("ERROR reading unsigned!\n");
+  if (strncmp(header, HEADERSTRING64, HEADERSIZE) == 0) {
+    wide = true;
+  } else if (strncmp(header, HEADERSTRING, HEADERSIZE) == 0) {
+    wide = false;
+  } else {
+    commAbort(c, "Unknown binary matrix file header");
   }
 
-  m->totalNr  = (CG_UINT)totalNr;
-  m->totalNnz = (CG_UINT)totalNnz;
-  printf("Rank %d: totalNr %u totalNnz %u\n", c->rank, m->totalNr, m->totalNnz);
-
-  // partition matrix row wise
-  int rank = c->rank;
-  int size = c->size;
-  int numRows, startRow, stopRow;
-
-  int cursor = 0;
-  for (int i = 0; i < rank + 1; i++) {
-    numRows  = sizeOfRank(i, size, totalNr);
-    startRow = cursor;
-    cursor += numRows;
-    stopRow = cursor - 1;
-  }
+  size_t indexSize = wide ? sizeof(unsigned long long) : sizeof(unsigned int);
 
-  printf("Rank %d: numRows %d startRow %d stopRow %d\n",
+  // read total matrix size
+  unsigned long long totals[2];
+  readIndices(fh, HEADERSIZE, totals, 2, wide);
+
+  m->totalNr  = (CG_GINT)totals[0];
+  m->totalNnz = (CG_GINT)totals[1];
+  printf("Rank %d: totalNr %lld totalNnz %lld\n", c->rank, m->totalNr, m->totalNnz);
+
+  // partition matrix row wise, non zero balanced splits search the row pointers
+  FileRowPtr ctx = { fh, HEADERSIZE + 2 * indexSize, wide };
+  CG_GINT startRow =
+      partitionStartRow(type, m->totalNr, fileRowPtr, &ctx, c->rank, c->size);
+  CG_GINT stopRow =
+      partitionStartRow(type, m->totalNr, fileRowPtr, &ctx, c->rank + 1, c->size) - 1;
+  CG_GINT numRows = stopRow - startRow + 1;
+
+  printf("Rank %d: numRows %lld startRow %lld stopRow %lld\n",
       c->rank,
       numRows,
       startRow,
       stopRow);
 
-  m->nr       = numRows;
-  m->nc       = numRows;
-  m->startRow = startRow;
-  m->stopRow  = stopRow;
-
-  // read row pointers
-  m->rowPtr = (CG_UINT *)allocate(ARRAY_ALIGNMENT, (numRows + 1) * sizeof(CG_UINT));
+  // read global row pointers of the local rows
+  unsigned long long *rowPtr = (unsigned long long *)allocate(
+      ARRAY_ALIGNMENT, (numRows + 1) * sizeof(unsigned long long));
+  MPI_Offset rowPtrOffset = HEADERSIZE + (2 + startRow) * indexSize;
+  readIndices(fh, rowPtrOffset, rowPtr, numRows + 1, wide);
 
-  MPI_File_get_position(fh, &offset);
-  MPI_File_seek(fh, startRow, MPI_SEEK_CUR);
-  MPI_File_read(fh, m->rowPtr, numRows + 1, MPI_UNSIGNED, &status);
-  MPI_Get_count(&status, MPI_UNSIGNED, &count);
-  if (count != numRows + 1) {
-    printf("ERROR reading rowptr!\n");
-  }
+  // the first row pointer is the offset of the local entries
+  unsigned long long entryOffset = rowPtr[0];
+  unsigned long long nnz         = rowPtr[numRows] - entryOffset;
 
-  // localize row pointer and determine local nnz
-  int nnz = 0;
-  for (int i = 0; i < numRows; i++) {
-    nnz += m->rowPtr[i + 1] - m->rowPtr[i];
+  if ((unsigned long long)numRows > CG_UINT_MAX || nnz > CG_UINT_MAX) {
+    commAbort(c, "Local matrix part exceeds index type, use more ranks or UINT_TYPE=ULL");
   }
 
-  m->nnz = (CG_UINT)nnz;
+  m->nr       = (CG_UINT)numRows;
+  m->nc       = (CG_UINT)numRows;
+  m->nnz      = (CG_UINT)nnz;
+  m->startRow = startRow;
+  m->stopRow  = stopRow;
 
-  // determine entry offset
-  int allnnz[size];
-  MPI_Allgather(&nnz, 1, MPI_INT, allnnz, 1, MPI_INT, MPI_COMM_WORLD);
-  MPI_Offset entryOffset = 0;
+  // localize row pointer
+  m->rowPtr = (CG_UINT *)allocate(ARRAY_ALIGNMENT, (numRows + 1) * sizeof(CG_UINT));
 
-  for (int i = 0; i < rank; i++) {
-    entryOffset += allnnz[i];
+  for (CG_GINT i = 0; i <= numRows; i++) {
+    m->rowPtr[i] = (CG_UINT)(rowPtr[i] - entryOffset);
   }
 
-  for (int i = 0; i <= numRows; i++) {
-    m->rowPtr[i] -= entryOffset;
-  }
+  free(rowPtr);
 
-  MPI_File_seek(fh, offset + m->totalNr + 1, MPI_SEEK_SET);
-  MPI_File_get_position(fh, &offset);
-  MPI_File_get_byte_offset(fh, offset, &disp);
+  MPI_Offset disp = HEADERSIZE + (2 + m->totalNr + 1) * indexSize +
+                    entryOffset * sizeof(FEntryType);
 
   FEntryType *entries =
       (FEntryType *)allocate(ARRAY_ALIGNMENT, m->nnz * sizeof(FEntryType));
   MPI_Datatype entryType;
   createEntrytype(&entryType);
-  MPI_File_set_view(fh, disp, entryType, entryType, "native", MPI_INFO_NULL);
-  MPI_File_seek(fh, entryOffset, MPI_SEEK_SET);
-  MPI_File_read(fh, entries, m->nnz, entryType, &status);
-  MPI_Get_count(&status, entryType, &count);
-  if (count != m->nnz) {
-    printf("ERROR reading rowptr!\n");
-  }
+  readLarge(fh, disp, entries, m->nnz, entryType);
   MPI_Type_free(&entryType);
   MPI_File_close(&fh);
 
   m->entries = (Entry *)allocate(ARRAY_ALIGNMENT, m->nnz * sizeof(Entry));
 
-  for (int i = 0; i < m->nnz; i++) {
-    m->entries[i].col = (CG_UINT)entries[i].col;
+  for (CG_UINT i = 0; i < m->nnz; i++) {
+    m->entries[i].col = (CG_GINT)entries[i].col;
     m->entries[i].val = (CG_FLOAT)entries[i].val;
   }
 
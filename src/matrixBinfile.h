@@ -7,18 +7,26 @@
 #include "comm.h"
 #include "matrix.h"
 
+#define HEADERSIZE 24
+#define HEADERSTRING "# SparseBench DataFile"
+#define HEADERSTRING64 "# SparseBench DataFile2"
+
 typedef struct {
   unsigned int col;
   float val;
 } FEntryType;
 
 // Matrix binary file format:
-// All ints are unsigned 32bit ints. All floats are float32.
+// <header string padded to HEADERSIZE bytes>
 // <number of rows> <number of non zeroes>
-// array of size <number of rows>[<row offset>]
+// array of size <number of rows + 1>[<row offset>]
 // array of size <number of non zeroes>[<<col id>,<value>>]
+//
+// With HEADERSTRING the counts and row offsets are unsigned 32bit ints, with
+// HEADERSTRING64 they are unsigned 64bit ints. Column ids are always unsigned
+// 32bit ints and values float32.
 
-extern void matrixBinWrite(GMatrix *m, CommType *c, char *filename);
-extern void matrixBinRead(GMatrix *m, CommType *c, char *filename);
+extern void matrixBinRead(
+    GMatrix *m, CommType *c, char *filename, DistributionType type);
 
 #endif // __MATRIXBINFILE_H_
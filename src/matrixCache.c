@@ -0,0 +1,216 @@
+/* Copyright (C) NHR@FAU, University Erlangen-Nuremberg.
+ * All rights reserved. This file is part of SparseBench.
+ * Use of this source code is governed by a MIT style
+ * license that can be found in the LICENSE file. */
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "allocate.h"
+#include "comm.h"
+#include "matrixCache.h"
+#include "util.h"
+
+#define CACHE_MAGIC "SBCACHE3"
+#define CACHE_MAGICSIZE 8
+#define CACHE_KEYSIZE 128
+#define HASH_BUFSIZE (1 << 20)
+#define FNV_OFFSET 14695981039346656037ULL
+#define FNV_PRIME 1099511628211ULL
+
+static uint64_t hashBytes(uint64_t hash, const unsigned char *buf, size_t n)
+{
+  for (size_t i = 0; i < n; i++) {
+    hash ^= buf[i];
+    hash *= FNV_PRIME;
+  }
+
+  return hash;
+}
+
+// FNV-1a hash of the matrix file contents or of the generator parameters
+static uint64_t hashMatrixSource(Parameter *p)
+{
+  uint64_t hash = FNV_OFFSET;
+
+  if (strcmp(p->filename, "generate") == 0 || strcmp(p->filename, "generate7P") == 0) {
+    char key[MAXLINE];
+    snprintf(key, sizeof(key), "%s %d %d %d", p->filename, p->nx, p->ny, p->nz);
+    return hashBytes(hash, (unsigned char *)key, strlen(key));
+  }
+
+  FILE *fp = fopen(p->filename, "rb");
+  if (fp == NULL) {
+    return 0;
+  }
+
+  unsigned char *buf = (unsigned char *)allocate(ARRAY_ALIGNMENT, HASH_BUFSIZE);
+  size_t n;
+
+  while ((n = fread(buf, 1, HASH_BUFSIZE, fp)) > 0) {
+    hash = hashBytes(hash, buf, n);
+  }
+
+  free(buf);
+  FCLOSE(fp);
+  return hash;
+}
+
+static void cacheKey(CommType *c, Parameter *p, char *key, size_t len)
+{
+  // Hashing large matrix files is expensive, only do it once per run
+  static bool hashed = false;
+  static uint64_t hash = 0;
+
+  if (!hashed) {
+    if (commIsMaster(c)) {
+      hash = hashMatrixSource(p);
+    }
+#ifdef _MPI
+    MPI_Bcast(&hash, 1, MPI_UINT64_T, 0, MPI_COMM_WORLD);
+#endif
+    hashed = true;
+  }
+
+  snprintf(key,
+      len,
+      "%016llx-%s-C%d-s%d-fp%zu-idx%zu-np%d-%s-%s",
+      (unsigned long long)hash,
+      p->format,
+      p->C,
+      p->sigma,
+      8 * sizeof(CG_FLOAT),
+      8 * sizeof(CG_UINT),
+      c->size,
+      p->distribution,
+      p->reorder);
+}
+
+static void cacheFilename(CommType *c, Parameter *p, char *key, char *name, size_t len)
+{
+  snprintf(name, len, "%s/sb-%s-r%d.cache", p->cachedir, key, c->rank);
+}
+
+// Open a cache file and position it behind a header matching key
+static FILE *cacheOpen(char *filename, char *key)
+{
+  FILE *fp = fopen(filename, "rb");
+  if (fp == NULL) {
+    return NULL;
+  }
+
+  char magic[CACHE_MAGICSIZE];
+  size_t keyLen = 0;
+  char storedKey[CACHE_KEYSIZE];
+
+  if (fread(magic, 1, CACHE_MAGICSIZE, fp) != CACHE_MAGICSIZE ||
+      memcmp(magic, CACHE_MAGIC, CACHE_MAGICSIZE) != 0 ||
+      fread(&keyLen, sizeof(size_t), 1, fp) != 1 || keyLen >= CACHE_KEYSIZE ||
+      fread(storedKey, 1, keyLen, fp) != keyLen) {
+    FCLOSE(fp);
+    return NULL;
+  }
+
+  storedKey[keyLen] = '\0';
+  if (strcmp(storedKey, key) != 0) {
+    FCLOSE(fp);
+    return NULL;
+  }
+
+  return fp;
+}
+
+/**
+ * @brief Load a localized and converted matrix from the cache.
+ *
+ * All ranks check for their cache file. Only if every rank finds a file with a
+ * matching key the matrix and the exchange plan are read, otherwise all ranks
+ * report a miss and the caller has to run the full setup.
+ *
+ * @param c Communication structure, the exchange plan is restored into it
+ * @param p Parameters, p->cachedir must be set
+ * @param[out] m Matrix to fill
+ * @return true on a cache hit
+ */
+bool cacheLoad(CommType *c, Parameter *p, Matrix *m)
+{
+  char key[CACHE_KEYSIZE];
+  char filename[MAXLINE];
+
+  cacheKey(c, p, key, sizeof(key));
+  cacheFilename(c, p, key, filename, sizeof(filename));
+  FILE *fp = cacheOpen(filename, key);
+
+  int hit  = (fp != NULL);
+#ifdef _MPI
+  MPI_Allreduce(MPI_IN_PLACE, &hit, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+#endif
+
+  if (!hit) {
+    if (fp != NULL) {
+      FCLOSE(fp);
+    }
+    if (commIsMaster(c)) {
+      printf("No cached matrix for key %s\n", key);
+    }
+    return false;
+  }
+
+  if (commIsMaster(c)) {
+    printf("Load cached matrix %s\n", key);
+  }
+
+  readMatrix(m, fp);
+  commReadTopology(c, fp);
+  FCLOSE(fp);
+
+  return true;
+}
+
+/**
+ * @brief Store a localized and converted matrix in the cache.
+ *
+ * Every rank writes its own part of the matrix together with its exchange plan.
+ * Failing to write the cache is not fatal.
+ *
+ * @param c Communication structure after commLocalization
+ * @param p Parameters, p->cachedir must be set
+ * @param m Converted matrix
+ */
+void cacheStore(CommType *c, Parameter *p, Matrix *m)
+{
+  char key[CACHE_KEYSIZE];
+  char filename[MAXLINE];
+
+  if (commIsMaster(c)) {
+    if (mkdir(p->cachedir, 0755) != 0 && errno != EEXIST) {
+      printf("Warning: Could not create cache directory %s\n", p->cachedir);
+    }
+  }
+  commBarrier();
+
+  cacheKey(c, p, key, sizeof(key));
+  cacheFilename(c, p, key, filename, sizeof(filename));
+
+  FILE *fp = fopen(filename, "wb");
+  if (fp == NULL) {
+    printf("Warning: Could not open cache file %s\n", filename);
+    return;
+  }
+
+  size_t keyLen = strlen(key);
+  FWRITE(CACHE_MAGIC, 1, CACHE_MAGICSIZE, fp);
+  FWRITE(&keyLen, sizeof(size_t), 1, fp);
+  FWRITE(key, 1, keyLen, fp);
+  writeMatrix(m, fp);
+  commWriteTopology(c, fp);
+  FCLOSE(fp);
+
+  if (commIsMaster(c)) {
+    printf("Stored matrix in cache %s\n", p->cachedir);
+  }
+}
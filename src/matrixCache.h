@@ -0,0 +1,26 @@
+/* Copyright (C) NHR@FAU, University Erlangen-Nuremberg.
+ * All rights reserved. This file is part of SparseBench.
+ * Use of this source code is governed by a MIT style
+ * license that can be found in the LICENSE file. */
+#ifndef __MATRIXCACHE_H_
+#define __MATRIXCACHE_H_
+#include <stdbool.h>
+
+#include "comm.h"
+#include "matrix.h"
+#include "parameter.h"
+
+// Matrix cache file format (one file per rank, native byte order):
+// <magic "SBCACHE3"> <key length> <key string>
+// <format specific Matrix dump, see writeMatrix>
+// <exchange plan, see commWriteTopology>
+//
+// The key consists of a hash of the matrix source (file contents or generator
+// parameters), the matrix format including C and sigma, the float and index
+// type, the number of ranks and the row distribution. It is also encoded in the
+// file name.
+
+extern bool cacheLoad(CommType *c, Parameter *p, Matrix *m);
+extern void cacheStore(CommType *c, Parameter *p, Matrix *m);
+
+#endif // __MATRIXCACHE_H_
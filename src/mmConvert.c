@@ -0,0 +1,385 @@
+/* Copyright (C) NHR@FAU, University Erlangen-Nuremberg.
+ * All rights reserved. This file is part of SparseBench.
+ * Use of this source code is governed by a MIT style
+ * license that can be found in the LICENSE file. */
+#include <limits.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "allocate.h"
+#include "matrixBinfile.h"
+#include "mmConvert.h"
+#include "mmio.h"
+#include "util.h"
+
+#define MAX_RUNS 512
+#define MIN_RUNBUFFER 4096
+#define OUTBUFFER 65536
+
+typedef struct {
+  unsigned int row;
+  unsigned int col;
+  float val;
+} RunEntry;
+
+typedef struct {
+  FILE *fp; // NULL if the run is held in memory only
+  RunEntry *buffer;
+  size_t capacity; // size of buffer in entries
+  size_t count; // valid entries in buffer
+  size_t cursor; // next entry to merge
+} Run;
+
+typedef struct {
+  FILE *rowPtrFile; // positioned at the row pointer array
+  FILE *entryFile; // positioned at the entry array
+  bool wide; // write counts and row pointers as 64 bit
+  unsigned long long nextRow; // next row whose row pointer is written
+  unsigned long long nnz; // entries written so far
+  FEntryType *buffer;
+  size_t count;
+} BinWriter;
+
+static inline bool lessRunEntry(const RunEntry *a, const RunEntry *b)
+{
+  return a->row < b->row || (a->row == b->row && a->col < b->col);
+}
+
+static int compareRunEntry(const void *a, const void *b)
+{
+  const RunEntry *a_ = (const RunEntry *)a;
+  const RunEntry *b_ = (const RunEntry *)b;
+
+  return lessRunEntry(b_, a_) - lessRunEntry(a_, b_);
+}
+
+static void runFilename(char *name, size_t len, char *outname, int id)
+{
+  snprintf(name, len, "%s.run%d", outname, id);
+}
+
+static void spillRun(RunEntry *entries, size_t count, char *outname, int id)
+{
+  char name[MAXLINE];
+  runFilename(name, sizeof(name), outname, id);
+
+  FILE *fp = fopen(name, "wb");
+  if (fp == NULL) {
+    fprintf(stderr, "Could not open run file %s\n", name);
+    exit(EXIT_FAILURE);
+  }
+
+  printf("Spill run %d with %zu entries\n", id, count);
+  FWRITE(entries, sizeof(RunEntry), count, fp);
+  FCLOSE(fp);
+}
+
+static bool refillRun(Run *r)
+{
+  if (r->fp == NULL) {
+    return false;
+  }
+
+  r->count  = fread(r->buffer, sizeof(RunEntry), r->capacity, r->fp);
+  r->cursor = 0;
+  return r->count > 0;
+}
+
+static inline RunEntry *runHead(Run *runs, int id)
+{
+  return &runs[id].buffer[runs[id].cursor];
+}
+
+static void siftDown(Run *runs, int *heap, int heapSize, int i)
+{
+  for (;;) {
+    int smallest = i;
+    int left     = 2 * i + 1;
+    int right    = 2 * i + 2;
+
+    if (left < heapSize &&
+        lessRunEntry(runHead(runs, heap[left]), runHead(runs, heap[smallest]))) {
+      smallest = left;
+    }
+    if (right < heapSize &&
+        lessRunEntry(runHead(runs, heap[right]), runHead(runs, heap[smallest]))) {
+      smallest = right;
+    }
+    if (smallest == i) {
+      return;
+    }
+
+    int tmp        = heap[i];
+    heap[i]        = heap[smallest];
+    heap[smallest] = tmp;
+    i              = smallest;
+  }
+}
+
+static void writeIndex(BinWriter *w, unsigned long long value)
+{
+  if (w->wide) {
+    FWRITE(&value, sizeof(unsigned long long), 1, w->rowPtrFile);
+  } else {
+    unsigned int narrow = (unsigned int)value;
+    FWRITE(&narrow, sizeof(unsigned int), 1, w->rowPtrFile);
+  }
+}
+
+static void flushEntries(BinWriter *w)
+{
+  FWRITE(w->buffer, sizeof(FEntryType), w->count, w->entryFile);
+  w->count = 0;
+}
+
+static void emitEntry(BinWriter *w, RunEntry *e)
+{
+  // Row pointers of all rows up to and including the row of e are known now
+  while (w->nextRow <= e->row) {
+    writeIndex(w, w->nnz);
+    w->nextRow++;
+  }
+
+  w->buffer[w->count].col   = e->col;
+  w->buffer[w->count++].val = e->val;
+  w->nnz++;
+
+  if (w->count == OUTBUFFER) {
+    flushEntries(w);
+  }
+}
+
+// Merge all runs into the output, the output file header is written by the caller
+static void mergeRuns(Run *runs, int numRuns, BinWriter *w)
+{
+  int heap[numRuns];
+  int heapSize = 0;
+
+  for (int i = 0; i < numRuns; i++) {
+    if (runs[i].count > 0 || refillRun(&runs[i])) {
+      heap[heapSize++] = i;
+    }
+  }
+
+  for (int i = heapSize / 2 - 1; i >= 0; i--) {
+    siftDown(runs, heap, heapSize, i);
+  }
+
+  while (heapSize > 0) {
+    Run *r = &runs[heap[0]];
+    emitEntry(w, &r->buffer[r->cursor++]);
+
+    if (r->cursor == r->count && !refillRun(r)) {
+      heap[0] = heap[--heapSize];
+    }
+
+    siftDown(runs, heap, heapSize, 0);
+  }
+}
+
+static FILE *openMM(
+    char *filename, MM_typecode *matcode, long long *M, long long *N, long long *nz)
+{
+  FILE *f = fopen(filename, "r");
+
+  if (f == NULL) {
+    printf("Unable to open file.\n");
+    exit(EXIT_FAILURE);
+  }
+
+  if (mm_read_banner(f, matcode) != 0) {
+    printf("Could not process Matrix Market banner.\n");
+    exit(EXIT_FAILURE);
+  }
+
+  if (!((mm_is_real(*matcode) || mm_is_pattern(*matcode) || mm_is_integer(*matcode)) &&
+          mm_is_matrix(*matcode) && mm_is_sparse(*matcode) &&
+          (mm_is_symmetric(*matcode) || mm_is_general(*matcode)))) {
+    fprintf(stderr, "Sorry, this application does not support ");
+    fprintf(stderr, "Market Market type: [%s]\n", mm_typecode_to_str(*matcode));
+    exit(EXIT_FAILURE);
+  }
+
+  if (mm_read_mtx_crd_size_ll(f, M, N, nz) != 0) {
+    exit(EXIT_FAILURE);
+  }
+
+  // Column ids are stored as 32 bit in the binary format
+  if (*M > UINT_MAX || *N > UINT_MAX) {
+    fprintf(stderr, "Matrix dimensions exceed binary matrix format limit\n");
+    exit(EXIT_FAILURE);
+  }
+
+  return f;
+}
+
+/**
+ * @brief Convert a Matrix Market file to a binary matrix file in bounded memory.
+ *
+ * Phase 1 reads chunks of at most memLimit bytes, expands symmetric entries,
+ * sorts every chunk by row and column and spills it to a run file. If all
+ * entries fit into one chunk nothing is spilled. Phase 2 merges all runs with a
+ * binary heap. Row pointers and entries are streamed through two file handles
+ * into their final positions, as the entry array offset only depends on the
+ * number of rows. If the number of non zeroes may exceed 32 bit the file is
+ * written with 64 bit counts and row pointers (HEADERSTRING64).
+ *
+ * @param filename Matrix Market input file
+ * @param outname Binary matrix output file
+ * @param memLimit Memory budget in bytes for entry buffers
+ */
+void mmConvertToBin(char *filename, char *outname, size_t memLimit)
+{
+  MM_typecode matcode;
+  long long M, N, nz;
+  FILE *f = openMM(filename, &matcode, &M, &N, &nz);
+
+  bool symFlag     = mm_is_symmetric(matcode);
+  bool patternFlag = mm_is_pattern(matcode);
+  size_t maxCount  = symFlag ? 2 * (size_t)nz : (size_t)nz;
+  size_t capacity  = MAX(MIN(memLimit / sizeof(RunEntry), maxCount), 2);
+  RunEntry *chunk  = (RunEntry *)allocate(ARRAY_ALIGNMENT, capacity * sizeof(RunEntry));
+  size_t count     = 0;
+  int numRuns      = 0;
+
+  printf("Convert matrix %s with %lld non zeroes and %lld rows to %s\n",
+      filename,
+      nz,
+      M,
+      outname);
+
+  for (size_t i = 0; i < (size_t)nz; i++) {
+    long long row, col;
+    double v = 1.0;
+    int items;
+
+    if (patternFlag) {
+      items = fscanf(f, "%lld %lld\n", &row, &col);
+    } else {
+      items = fscanf(f, "%lld %lld %lg%*[^\n]\n", &row, &col, &v);
+    }
+
+    if (items < 2 || row < 1 || row > M || col < 1 || col > N) {
+      fprintf(stderr, "Invalid entry %zu in %s\n", i + 1, filename);
+      exit(EXIT_FAILURE);
+    }
+
+    // Keep room for the transposed entry of a symmetric matrix
+    if (count + 2 > capacity) {
+      qsort(chunk, count, sizeof(RunEntry), compareRunEntry);
+      spillRun(chunk, count, outname, numRuns++);
+      count = 0;
+    }
+
+    row--; /* adjust from 1-based to 0-based */
+    col--;
+
+    chunk[count].row   = (unsigned int)row;
+    chunk[count].col   = (unsigned int)col;
+    chunk[count++].val = (float)v;
+
+    if (symFlag && (row != col)) {
+      chunk[count].row   = (unsigned int)col;
+      chunk[count].col   = (unsigned int)row;
+      chunk[count++].val = (float)v;
+    }
+  }
+
+  FCLOSE(f);
+  qsort(chunk, count, sizeof(RunEntry), compareRunEntry);
+
+  Run runs[numRuns + 1];
+
+  if (numRuns > 0) {
+    // Spill the last chunk as well to have the full budget for merge buffers
+    spillRun(chunk, count, outname, numRuns++);
+    free(chunk);
+
+    if (numRuns > MAX_RUNS) {
+      fprintf(stderr,
+          "Too many runs (%d), increase the conversion memory budget\n",
+          numRuns);
+      exit(EXIT_FAILURE);
+    }
+
+    size_t runCapacity = MAX(memLimit / (numRuns * sizeof(RunEntry)), MIN_RUNBUFFER);
+
+    for (int i = 0; i < numRuns; i++) {
+      char name[MAXLINE];
+      runFilename(name, sizeof(name), outname, i);
+
+      runs[i].fp = fopen(name, "rb");
+      if (runs[i].fp == NULL) {
+        fprintf(stderr, "Could not open run file %s\n", name);
+        exit(EXIT_FAILURE);
+      }
+      runs[i].capacity = runCapacity;
+      runs[i].buffer =
+          (RunEntry *)allocate(ARRAY_ALIGNMENT, runCapacity * sizeof(RunEntry));
+      runs[i].count  = 0;
+      runs[i].cursor = 0;
+    }
+  } else {
+    // Everything fit into memory, merge the single chunk directly
+    runs[0].fp       = NULL;
+    runs[0].buffer   = chunk;
+    runs[0].capacity = capacity;
+    runs[0].count    = count;
+    runs[0].cursor   = 0;
+    numRuns          = 1;
+  }
+
+  BinWriter w;
+  w.rowPtrFile = fopen(outname, "wb");
+  if (w.rowPtrFile == NULL) {
+    fprintf(stderr, "Could not open output file %s\n", outname);
+    exit(EXIT_FAILURE);
+  }
+  w.entryFile = fopen(outname, "r+b");
+  if (w.entryFile == NULL) {
+    fprintf(stderr, "Could not open output file %s\n", outname);
+    exit(EXIT_FAILURE);
+  }
+  w.wide    = maxCount > UINT_MAX;
+  w.nextRow = 0;
+  w.nnz     = 0;
+  w.count   = 0;
+  w.buffer  = (FEntryType *)allocate(ARRAY_ALIGNMENT, OUTBUFFER * sizeof(FEntryType));
+
+  char header[HEADERSIZE];
+  size_t indexSize = w.wide ? sizeof(unsigned long long) : sizeof(unsigned int);
+  strncpy(header, w.wide ? HEADERSTRING64 : HEADERSTRING, HEADERSIZE);
+  FWRITE(header, 1, HEADERSIZE, w.rowPtrFile);
+  writeIndex(&w, (unsigned long long)M);
+  writeIndex(&w, w.nnz);
+  fseek(w.entryFile, HEADERSIZE + (2 + M + 1) * indexSize, SEEK_SET);
+
+  mergeRuns(runs, numRuns, &w);
+
+  flushEntries(&w);
+  while (w.nextRow <= (unsigned long long)M) {
+    writeIndex(&w, w.nnz);
+    w.nextRow++;
+  }
+  FCLOSE(w.entryFile);
+
+  fseek(w.rowPtrFile, HEADERSIZE + indexSize, SEEK_SET);
+  writeIndex(&w, w.nnz);
+  FCLOSE(w.rowPtrFile);
+  free(w.buffer);
+
+  for (int i = 0; i < numRuns; i++) {
+    free(runs[i].buffer);
+
+    if (runs[i].fp != NULL) {
+      char name[MAXLINE];
+      runFilename(name, sizeof(name), outname, i);
+      FCLOSE(runs[i].fp);
+      remove(name);
+    }
+  }
+
+  printf("Wrote %lld rows and %llu non zeroes to %s\n", M, w.nnz, outname);
+}
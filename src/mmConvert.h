@@ -0,0 +1,16 @@
+/* Copyright (C) NHR@FAU, University Erlangen-Nuremberg.
+ * All rights reserved. This file is part of SparseBench.
+ * Use of this source code is governed by a MIT style
+ * license that can be found in the LICENSE file. */
+#ifndef __MMCONVERT_H_
+#define __MMCONVERT_H_
+#include <stddef.h>
+
+// Out-of-core conversion of a Matrix Market file into the binary matrix
+// format described in matrixBinfile.h. Entries are read in chunks of at most
+// memLimit bytes, symmetric entries are expanded on the fly, every chunk is
+// sorted in CRS order and spilled to a temporary run file next to the output
+// file. The runs are then k-way merged directly into the output file.
+extern void mmConvertToBin(char *filename, char *outname, size_t memLimit);
+
+#endif // __MMCONVERT_H_
@@ -195,6 +195,35 @@ int mm_read_mtx_crd_size(FILE *f, int *M, int *N, int *nz)
   return 0;
 }
 
+/* 64-bit variant for matrices with more than 2^31 rows or non zeros */
+int mm_read_mtx_crd_size_ll(FILE *f, long long *M, long long *N, long long *nz)
+{
+  char line[MM_MAX_LINE_LENGTH];
+  int num_items_read;
+
+  /* set return null parameter values, in case we exit with errors */
+  *M = *N = *nz = 0;
+
+  /* now continue scanning until you reach the end-of-comments */
+  do {
+    if (fgets(line, MM_MAX_LINE_LENGTH, f) == NULL)
+      return MM_PREMATURE_EOF;
+  } while (line[0] == '%');
+
+  /* line[] is either blank or has M,N, nz */
+  if (sscanf(line, "%lld %lld %lld", M, N, nz) == 3)
+    return 0;
+
+  else
+    do {
+      num_items_read = fscanf(f, "%lld %lld %lld", M, N, nz);
+      if (num_items_read == EOF)
+        return MM_PREMATURE_EOF;
+    } while (num_items_read != 3);
+
+  return 0;
+}
+
 int mm_read_mtx_array_size(FILE *f, int *M, int *N)
 {
   char line[MM_MAX_LINE_LENGTH];
@@ -11,12 +11,28 @@
 
 void initParameter(Parameter *param)
 {
-  param->filename = "generate";
-  param->nx       = 100;
-  param->ny       = 100;
-  param->nz       = 100;
-  param->itermax  = 150;
-  param->eps      = 0.0;
+  param->filename     = "generate";
+  param->format       = "CRS";
+  param->nx           = 100;
+  param->ny           = 100;
+  param->nz           = 100;
+  param->itermax      = 150;
+  param->eps          = 0.0;
+  param->C            = 1;
+  param->sigma        = 1;
+  param->cachedir     = NULL;
+  param->memlimit     = 1024;
+  param->distribution = "rows";
+  param->reorder      = "none";
+  param->json         = NULL;
+  param->xreuse       = 0.0;
+  param->membw        = 0.0;
+  param->stream       = 0;
+  param->warmup       = 2;
+  param->trace        = NULL;
+  param->commcsv      = NULL;
+  param->tunefile     = NULL;
+  param->lossy        = 0;
 }
 
 void readParameter(Parameter *param, const char *filename)
@@ -50,11 +66,27 @@ void readParameter(Parameter *param, const char *filename)
 
     if (tok != NULL && val != NULL) {
       PARSE_STRING(filename);
+      PARSE_STRING(format);
       PARSE_INT(nx);
       PARSE_INT(ny);
       PARSE_INT(nz);
       PARSE_INT(itermax);
       PARSE_REAL(eps);
+      PARSE_INT(C);
+      PARSE_INT(sigma);
+      PARSE_STRING(cachedir);
+      PARSE_INT(memlimit);
+      PARSE_STRING(distribution);
+      PARSE_STRING(reorder);
+      PARSE_STRING(json);
+      PARSE_REAL(xreuse);
+      PARSE_REAL(membw);
+      PARSE_INT(stream);
+      PARSE_INT(warmup);
+      PARSE_STRING(trace);
+      PARSE_STRING(commcsv);
+      PARSE_STRING(tunefile);
+      PARSE_INT(lossy);
     }
   }
 
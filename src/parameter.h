@@ -7,23 +7,28 @@
 
 typedef struct {
   char *filename;
+  char *format; // storage format: CRS, SCS, CCRS, CRS16, CRSF, STENCIL, SYM or BCSR
   int nx, ny, nz;
   int itermax;
   double eps;
+  int C, sigma; // SELL-C-sigma chunk height and sorting scope
+  char *cachedir; // directory for cached matrices, NULL disables the cache
+  int memlimit; // memory budget in MB for out-of-core matrix conversion
+  char *distribution; // row distribution among ranks: rows, nnz, cost or graph
+  char *reorder; // ordering of the rank local rows: none or rcm
+  char *json; // file for results in JSON format, NULL disables it
+  double xreuse; // x loads per matrix element in the spMVM traffic model
+  double membw; // measured memory bandwidth in GB/s, 0 disables it
+  int stream; // array size in MB per rank for the bandwidth calibration, 0 skips it
+  int warmup; // untimed iterations before the benchmark
+  char *trace; // file for the event timeline in Chrome trace format, NULL disables it
+  char *commcsv; // file for the communication matrix in CSV format, NULL disables it
+  char *tunefile; // parameter file for the format found by the tuner, NULL disables it
+  int lossy; // let the tuner try CRSF with single precision matrix values
 } Parameter;
 
 void initParameter(Parameter *);
 void readParameter(Parameter *, const char *);
 void printParameter(Parameter *);
 
-#ifdef CRS
-#define FMT "CRS"
-#endif
-#ifdef SCS
-#define FMT "SCS"
-#endif
-#ifdef CCRS
-#define FMT "CCRS"
-#endif
-
 #endif
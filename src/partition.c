@@ -0,0 +1,423 @@
+/* Copyright (C) NHR@FAU, University Erlangen-Nuremberg.
+ * All rights reserved. This file is part of SparseBench.
+ * Use of this source code is governed by a MIT style
+ * license that can be found in the LICENSE file. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "allocate.h"
+#include "partition.h"
+#include "util.h"
+
+// Cost model in bytes of one CG iteration: per non zero the value and the column
+// index, per row the row pointer and 14 vector element accesses of spMVM, three
+// waxpby and two ddot calls.
+#define COST_NNZ (sizeof(CG_FLOAT) + sizeof(CG_UINT))
+#define COST_ROW (sizeof(CG_UINT) + 14 * sizeof(CG_FLOAT))
+
+static const char *DistributionNames[NUMDIST] = { "rows", "nnz", "cost", "graph" };
+
+PartitionStats PartStats = { .valid = false };
+
+// Adjacency structure of the matrix graph, vertices are rows and edges are the
+// non zeros. Every vertex is weighted with its number of non zeros.
+typedef struct {
+  CG_GINT nv;
+  CG_GINT *rowPtr;
+  CG_GINT *cols;
+} Graph;
+
+// Scratch space shared by all levels of the recursive bisection
+typedef struct {
+  int *part; // current part of each vertex
+  CG_GINT *visited; // stamp of the last search that reached a vertex
+  CG_GINT stamp;
+  CG_GINT *queue;
+  CG_GINT *tmp;
+} Workspace;
+
+DistributionType partitionType(const char *name)
+{
+  for (int i = 0; i < NUMDIST; i++) {
+    if (strcmp(name, DistributionNames[i]) == 0) {
+      return (DistributionType)i;
+    }
+  }
+
+  printf("Unknown row distribution %s\n", name);
+  exit(EXIT_FAILURE);
+}
+
+const char *partitionName(DistributionType type)
+{
+  return DistributionNames[type];
+}
+
+// Prefix sum of the partitioning weight over the rows [0, row)
+static double prefixWeight(
+    DistributionType type, CG_GINT row, RowPtrFunc rowPtr, void *ctx)
+{
+  switch (type) {
+  case DIST_NNZ:
+    return (double)rowPtr(ctx, row);
+  case DIST_COST:
+    return (double)COST_ROW * row + (double)COST_NNZ * rowPtr(ctx, row);
+  default:
+    return (double)row;
+  }
+}
+
+/**
+ * @brief Compute the first global row owned by a rank.
+ *
+ * With DIST_ROWS all ranks get the same number of rows, the first
+ * totalNr % size ranks one more. Otherwise the rows are split such that the
+ * prefix sum of the weight (non zeroes or modelled cost) at every split is as
+ * close as possible to rank / size of the total weight. The split is found by
+ * a binary search over the monotonic prefix sum, which needs O(log totalNr)
+ * row pointer lookups.
+ *
+ * @param type Distribution type
+ * @param totalNr Total number of rows
+ * @param rowPtr Lookup of the global row pointer
+ * @param ctx Context passed to rowPtr
+ * @param rank Rank to compute the first row for, size returns totalNr
+ * @param size Number of ranks
+ * @return First global row of rank
+ */
+CG_GINT partitionStartRow(DistributionType type,
+    CG_GINT totalNr,
+    RowPtrFunc rowPtr,
+    void *ctx,
+    int rank,
+    int size)
+{
+  if (type == DIST_ROWS) {
+    return rank * (totalNr / size) + MIN(rank, totalNr % size);
+  }
+  if (rank <= 0) {
+    return 0;
+  }
+  if (rank >= size) {
+    return totalNr;
+  }
+
+  double target = prefixWeight(type, totalNr, rowPtr, ctx) * rank / size;
+  CG_GINT lo    = 0;
+  CG_GINT hi    = totalNr;
+
+  // Find the first row whose prefix weight reaches the target
+  while (lo < hi) {
+    CG_GINT mid = lo + (hi - lo) / 2;
+
+    if (prefixWeight(type, mid, rowPtr, ctx) < target) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+
+  // Split before or after the row crossing the target, whichever is closer
+  if (lo > 0 && target - prefixWeight(type, lo - 1, rowPtr, ctx) <
+                    prefixWeight(type, lo, rowPtr, ctx) - target) {
+    lo--;
+  }
+
+  return lo;
+}
+
+static inline int compareRowCol(const void *a, const void *b)
+{
+  const MMEntry *a_ = (const MMEntry *)a;
+  const MMEntry *b_ = (const MMEntry *)b;
+
+  if (a_->row != b_->row) {
+    return (a_->row > b_->row) - (a_->row < b_->row);
+  }
+  return (a_->col > b_->col) - (a_->col < b_->col);
+}
+
+static inline CG_GINT vertexWeight(Graph *g, CG_GINT v)
+{
+  return g->rowPtr[v + 1] - g->rowPtr[v];
+}
+
+// Breadth first search within part from start, returns the last vertex reached.
+// Starting the bisection there yields a pseudo-peripheral start vertex and thus
+// level sets with small cross sections.
+static CG_GINT lastReached(Graph *g, Workspace *w, CG_GINT start, int part)
+{
+  CG_GINT head = 0;
+  CG_GINT tail = 0;
+  CG_GINT v    = start;
+
+  w->stamp++;
+  w->visited[start] = w->stamp;
+  w->queue[tail++]  = start;
+
+  while (head < tail) {
+    v = w->queue[head++];
+
+    for (CG_GINT j = g->rowPtr[v]; j < g->rowPtr[v + 1]; j++) {
+      CG_GINT u = g->cols[j];
+
+      if (w->part[u] == part && w->visited[u] != w->stamp) {
+        w->visited[u]    = w->stamp;
+        w->queue[tail++] = u;
+      }
+    }
+  }
+
+  return v;
+}
+
+/**
+ * @brief Recursively bisect a set of vertices into nparts parts.
+ *
+ * All vertices in the set are labeled with firstPart on entry. A breadth first
+ * search grown from a pseudo-peripheral vertex collects the first part until it
+ * holds leftParts / nparts of the total weight, disconnected components are
+ * entered in vertex order. The remaining vertices are relabeled and both halves
+ * are bisected further. The vertex set is stably partitioned in place, so both
+ * halves keep the original vertex order.
+ *
+ * @param g Matrix graph
+ * @param w Workspace, w->part holds the result
+ * @param vertices Vertex set to split
+ * @param count Number of vertices in the set
+ * @param firstPart Label of the set and of the first resulting part
+ * @param nparts Number of parts to create from the set
+ */
+static void bisect(
+    Graph *g, Workspace *w, CG_GINT *vertices, CG_GINT count, int firstPart, int nparts)
+{
+  if (nparts == 1 || count == 0) {
+    return;
+  }
+
+  int leftParts = nparts / 2;
+  double total  = 0.0;
+
+  for (CG_GINT i = 0; i < count; i++) {
+    total += vertexWeight(g, vertices[i]);
+  }
+
+  double target = total * leftParts / nparts;
+  double grown  = 0.0;
+  CG_GINT head  = 0;
+  CG_GINT tail  = 0;
+  CG_GINT next  = 0;
+  CG_GINT start = lastReached(g, w, vertices[0], firstPart);
+
+  w->stamp++;
+  w->visited[start] = w->stamp;
+  w->queue[tail++]  = start;
+
+  while (grown < target) {
+    if (head == tail) {
+      // Component exhausted, continue with the next unvisited vertex
+      while (next < count && w->visited[vertices[next]] == w->stamp) {
+        next++;
+      }
+      if (next == count) {
+        break;
+      }
+      w->visited[vertices[next]] = w->stamp;
+      w->queue[tail++]           = vertices[next];
+    }
+
+    CG_GINT v = w->queue[head++];
+    grown += vertexWeight(g, v);
+
+    for (CG_GINT j = g->rowPtr[v]; j < g->rowPtr[v + 1]; j++) {
+      CG_GINT u = g->cols[j];
+
+      if (w->part[u] == firstPart && w->visited[u] != w->stamp) {
+        w->visited[u]    = w->stamp;
+        w->queue[tail++] = u;
+      }
+    }
+  }
+
+  // Vertices taken from the queue form the first part, relabel all others
+  w->stamp++;
+  for (CG_GINT i = 0; i < head; i++) {
+    w->visited[w->queue[i]] = w->stamp;
+  }
+
+  CG_GINT leftCount = 0;
+  CG_GINT cursor    = 0;
+
+  for (CG_GINT i = 0; i < count; i++) {
+    CG_GINT v = vertices[i];
+
+    if (w->visited[v] == w->stamp) {
+      vertices[leftCount++] = v;
+    } else {
+      w->part[v]       = firstPart + leftParts;
+      w->tmp[cursor++] = v;
+    }
+  }
+  memcpy(vertices + leftCount, w->tmp, cursor * sizeof(CG_GINT));
+
+  bisect(g, w, vertices, leftCount, firstPart, leftParts);
+  bisect(g,
+      w,
+      vertices + leftCount,
+      count - leftCount,
+      firstPart + leftParts,
+      nparts - leftParts);
+}
+
+// Count off-part non zeros and the neighbor parts of every part
+static void partitionQuality(Graph *g, const int *part, int size, int stage)
+{
+  char *adjacent   = (char *)allocate(ARRAY_ALIGNMENT, (size_t)size * size);
+  CG_GINT cutEdges = 0;
+
+  memset(adjacent, 0, (size_t)size * size);
+
+  for (CG_GINT v = 0; v < g->nv; v++) {
+    for (CG_GINT j = g->rowPtr[v]; j < g->rowPtr[v + 1]; j++) {
+      int p = part[g->cols[j]];
+
+      if (p != part[v]) {
+        cutEdges++;
+        adjacent[(size_t)part[v] * size + p] = 1;
+      }
+    }
+  }
+
+  int maxNeighbors = 0;
+  int sumNeighbors = 0;
+
+  for (int i = 0; i < size; i++) {
+    int neighbors = 0;
+
+    for (int k = 0; k < size; k++) {
+      neighbors += adjacent[(size_t)i * size + k];
+    }
+    maxNeighbors = MAX(maxNeighbors, neighbors);
+    sumNeighbors += neighbors;
+  }
+
+  PartStats.cutEdges[stage]     = cutEdges;
+  PartStats.maxNeighbors[stage] = maxNeighbors;
+  PartStats.avgNeighbors[stage] = (double)sumNeighbors / size;
+
+  free(adjacent);
+}
+
+/**
+ * @brief Partition the matrix graph and renumber rows and columns.
+ *
+ * The rows are split into size parts of similar non zero count by recursive
+ * graph growing bisection, which keeps coupled rows in the same part and
+ * thereby reduces the halo volume and the number of neighbors of every rank.
+ * Afterwards rows and columns are renumbered such that each part is a
+ * contiguous range of rows, keeping the original order within a part, and the
+ * entries are sorted again. The partition quality before and after is stored
+ * in PartStats.
+ *
+ * The matrix must be structurally symmetric for the resulting cut to be
+ * meaningful, for other matrices the partitioning is still valid.
+ *
+ * @param[in,out] m Complete matrix with entries sorted by row
+ * @param size Number of parts
+ * @param[out] startRows First row of every part, startRows[size] is the
+ *             number of rows
+ */
+void partitionGraph(MMMatrix *m, int size, CG_GINT *startRows)
+{
+  Graph g;
+  Workspace w;
+  CG_GINT nv = m->nr;
+
+  g.nv     = nv;
+  g.rowPtr = (CG_GINT *)allocate(ARRAY_ALIGNMENT, (nv + 1) * sizeof(CG_GINT));
+  g.cols   = (CG_GINT *)allocate(ARRAY_ALIGNMENT, m->count * sizeof(CG_GINT));
+
+  for (CG_GINT i = 0; i <= nv; i++) {
+    g.rowPtr[i] = 0;
+  }
+  for (size_t i = 0; i < m->count; i++) {
+    g.rowPtr[m->entries[i].row + 1]++;
+    g.cols[i] = m->entries[i].col;
+  }
+  for (CG_GINT i = 0; i < nv; i++) {
+    g.rowPtr[i + 1] += g.rowPtr[i];
+  }
+
+  w.part    = (int *)allocate(ARRAY_ALIGNMENT, nv * sizeof(int));
+  w.visited = (CG_GINT *)allocate(ARRAY_ALIGNMENT, nv * sizeof(CG_GINT));
+  w.queue   = (CG_GINT *)allocate(ARRAY_ALIGNMENT, nv * sizeof(CG_GINT));
+  w.tmp     = (CG_GINT *)allocate(ARRAY_ALIGNMENT, nv * sizeof(CG_GINT));
+  w.stamp   = 0;
+
+  // Quality of the plain row blocks
+  for (int r = 0; r < size; r++) {
+    CG_GINT start = partitionStartRow(DIST_ROWS, nv, NULL, NULL, r, size);
+    CG_GINT stop  = partitionStartRow(DIST_ROWS, nv, NULL, NULL, r + 1, size);
+
+    for (CG_GINT i = start; i < stop; i++) {
+      w.part[i] = r;
+    }
+  }
+  partitionQuality(&g, w.part, size, 0);
+
+  CG_GINT *vertices = (CG_GINT *)allocate(ARRAY_ALIGNMENT, nv * sizeof(CG_GINT));
+
+  for (CG_GINT i = 0; i < nv; i++) {
+    w.part[i]    = 0;
+    w.visited[i] = 0;
+    vertices[i]  = i;
+  }
+
+  bisect(&g, &w, vertices, nv, 0, size);
+  partitionQuality(&g, w.part, size, 1);
+  PartStats.valid = true;
+
+  // Counting sort of the rows by part gives the new numbering
+  CG_GINT *newIndex = vertices;
+
+  for (int r = 0; r <= size; r++) {
+    startRows[r] = 0;
+  }
+  for (CG_GINT i = 0; i < nv; i++) {
+    startRows[w.part[i] + 1]++;
+  }
+  for (int r = 0; r < size; r++) {
+    startRows[r + 1] += startRows[r];
+  }
+
+  CG_GINT *cursor = (CG_GINT *)allocate(ARRAY_ALIGNMENT, size * sizeof(CG_GINT));
+
+  for (int r = 0; r < size; r++) {
+    cursor[r] = startRows[r];
+  }
+  for (CG_GINT i = 0; i < nv; i++) {
+    newIndex[i] = cursor[w.part[i]]++;
+  }
+
+  for (size_t i = 0; i < m->count; i++) {
+    m->entries[i].row = newIndex[m->entries[i].row];
+    m->entries[i].col = newIndex[m->entries[i].col];
+  }
+  qsort(m->entries, m->count, sizeof(MMEntry), compareRowCol);
+
+  printf("Graph partitioning: cut edges %lld -> %lld, max neighbors %d -> %d\n",
+      PartStats.cutEdges[0],
+      PartStats.cutEdges[1],
+      PartStats.maxNeighbors[0],
+      PartStats.maxNeighbors[1]);
+
+  free(cursor);
+  free(vertices);
+  free(w.tmp);
+  free(w.queue);
+  free(w.visited);
+  free(w.part);
+  free(g.cols);
+  free(g.rowPtr);
+}
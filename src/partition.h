@@ -0,0 +1,37 @@
+/* Copyright (C) NHR@FAU, University Erlangen-Nuremberg.
+ * All rights reserved. This file is part of SparseBench.
+ * Use of this source code is governed by a MIT style
+ * license that can be found in the LICENSE file. */
+#ifndef __PARTITION_H_
+#define __PARTITION_H_
+#include "matrix.h"
+#include "util.h"
+
+typedef enum { DIST_ROWS = 0, DIST_NNZ, DIST_COST, DIST_GRAPH, NUMDIST } DistributionType;
+
+// Partition quality of equal row blocks in the original numbering ([0]) and of
+// the graph partitioning ([1]). Only set on the master rank with DIST_GRAPH.
+typedef struct {
+  bool valid;
+  CG_GINT cutEdges[2]; // off-part non zeros
+  int maxNeighbors[2]; // maximum number of neighbor parts of a part
+  double avgNeighbors[2]; // average number of neighbor parts
+} PartitionStats;
+
+extern PartitionStats PartStats;
+
+// Returns the global row pointer of a row. This allows to evaluate prefix sums
+// over row lengths without holding the complete row pointer array.
+typedef CG_GINT (*RowPtrFunc)(void *ctx, CG_GINT row);
+
+extern DistributionType partitionType(const char *name);
+extern const char *partitionName(DistributionType type);
+extern CG_GINT partitionStartRow(DistributionType type,
+    CG_GINT totalNr,
+    RowPtrFunc rowPtr,
+    void *ctx,
+    int rank,
+    int size);
+extern void partitionGraph(MMMatrix *m, int size, CG_GINT *startRows);
+
+#endif // __PARTITION_H_
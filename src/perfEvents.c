@@ -0,0 +1,364 @@
+/* Copyright (C) NHR@FAU, University Erlangen-Nuremberg.
+ * All rights reserved. This file is part of SparseBench.
+ * Use of this source code is governed by a MIT style
+ * license that can be found in the LICENSE file. */
+#ifdef PERF_EVENTS
+#include <dirent.h>
+#include <linux/perf_event.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "allocate.h"
+#include "perfEvents.h"
+#include "util.h"
+
+#define NUMTHREADEVENTS 3
+#define MAXIMC 64
+#define SYSFS_PMU "/sys/bus/event_source/devices"
+
+// Counter group of one thread, the first opened event is the group leader
+typedef struct {
+  int leader;
+  int fd[NUMTHREADEVENTS]; // -1 if the event is not supported
+  int index[NUMTHREADEVENTS]; // position of the event in a group read
+  uint64_t start[NUMTHREADEVENTS];
+} ThreadCounters;
+
+static const uint64_t ThreadEvents[NUMTHREADEVENTS] = { PERF_COUNT_HW_CPU_CYCLES,
+  PERF_COUNT_HW_INSTRUCTIONS,
+  PERF_COUNT_HW_CACHE_MISSES };
+
+static int NumThreads          = 0;
+static int NumRegions          = 0;
+static ThreadCounters *Threads = NULL;
+static double *Counts          = NULL; // [region][thread][event]
+static bool Available[NUMPERF];
+
+// Memory controller events, counted for the whole socket by thread 0
+static int NumImc = 0;
+static int ImcFd[MAXIMC];
+static double ImcBytes[MAXIMC]; // bytes per count
+static uint64_t ImcStart[MAXIMC];
+
+static int perfEventOpen(struct perf_event_attr *attr, pid_t pid, int cpu, int group)
+{
+  return (int)syscall(SYS_perf_event_open, attr, pid, cpu, group, 0);
+}
+
+static int threadId(void)
+{
+#ifdef _OPENMP
+  return omp_get_thread_num();
+#else
+  return 0;
+#endif
+}
+
+static void openThreadCounters(ThreadCounters *t)
+{
+  int count = 0;
+
+  t->leader = -1;
+
+  for (int e = 0; e < NUMTHREADEVENTS; e++) {
+    struct perf_event_attr attr;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.size           = sizeof(attr);
+    attr.type           = PERF_TYPE_HARDWARE;
+    attr.config         = ThreadEvents[e];
+    attr.disabled       = (t->leader == -1);
+    attr.exclude_kernel = 1;
+    attr.exclude_hv     = 1;
+    attr.read_format    = PERF_FORMAT_GROUP;
+
+    t->fd[e]            = perfEventOpen(&attr, 0, -1, t->leader);
+    if (t->fd[e] >= 0) {
+      if (t->leader == -1) {
+        t->leader = t->fd[e];
+      }
+      t->index[e] = count++;
+    }
+  }
+
+  if (t->leader >= 0) {
+    ioctl(t->leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(t->leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+  }
+}
+
+static void readThreadCounters(ThreadCounters *t, uint64_t *values)
+{
+  uint64_t buffer[1 + NUMTHREADEVENTS];
+
+  if (t->leader < 0 ||
+      read(t->leader, buffer, sizeof(buffer)) < (ssize_t)sizeof(uint64_t)) {
+    memset(values, 0, NUMTHREADEVENTS * sizeof(uint64_t));
+    return;
+  }
+
+  for (int e = 0; e < NUMTHREADEVENTS; e++) {
+    values[e] = t->fd[e] >= 0 ? buffer[1 + t->index[e]] : 0;
+  }
+}
+
+// Read the first line of a sysfs file whose path is given printf like
+static bool readSysfs(char *buffer, size_t len, const char *format, ...)
+{
+  char path[MAXLINE];
+  va_list args;
+
+  va_start(args, format);
+  vsnprintf(path, sizeof(path), format, args);
+  va_end(args);
+
+  FILE *fp = fopen(path, "r");
+  if (fp == NULL) {
+    return false;
+  }
+
+  bool ok = fgets(buffer, (int)len, fp) != NULL;
+  fclose(fp);
+  if (ok) {
+    buffer[strcspn(buffer, "\n")] = '\0';
+  }
+  return ok;
+}
+
+// Translate an event description like "event=0x04,umask=0x03" into the config
+// value using the bit ranges in the format directory of the PMU
+static bool parseEventConfig(const char *pmu, char *spec, uint64_t *config)
+{
+  char format[MAXLINE];
+  char *save = NULL;
+  char *term = strtok_r(spec, ",", &save);
+
+  *config    = 0;
+  while (term != NULL) {
+    char *value = strchr(term, '=');
+    int lo      = 0;
+
+    if (value == NULL) {
+      return false;
+    }
+    *value++ = '\0';
+    if (!readSysfs(format, sizeof(format), SYSFS_PMU "/%s/format/%s", pmu, term) ||
+        sscanf(format, "config:%d", &lo) != 1) {
+      return false;
+    }
+    *config |= strtoull(value, NULL, 0) << lo;
+    term = strtok_r(NULL, ",", &save);
+  }
+
+  return true;
+}
+
+static void openImcEvent(const char *pmu, const char *event)
+{
+  char buffer[MAXLINE];
+  int type = 0;
+  int cpu  = 0;
+  uint64_t config;
+
+  if (NumImc == MAXIMC ||
+      !readSysfs(buffer, sizeof(buffer), SYSFS_PMU "/%s/type", pmu) ||
+      sscanf(buffer, "%d", &type) != 1) {
+    return;
+  }
+  if (readSysfs(buffer, sizeof(buffer), SYSFS_PMU "/%s/cpumask", pmu)) {
+    sscanf(buffer, "%d", &cpu);
+  }
+  if (!readSysfs(buffer, sizeof(buffer), SYSFS_PMU "/%s/events/%s", pmu, event) ||
+      !parseEventConfig(pmu, buffer, &config)) {
+    return;
+  }
+
+  // The scale converts counts into the unit of the event, usually MiB
+  double bytes = PERF_CACHELINE;
+  if (readSysfs(buffer, sizeof(buffer), SYSFS_PMU "/%s/events/%s.scale", pmu, event)) {
+    bytes = atof(buffer) * 1024.0 * 1024.0;
+  }
+
+  struct perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.size   = sizeof(attr);
+  attr.type   = type;
+  attr.config = config;
+
+  int fd      = perfEventOpen(&attr, -1, cpu, -1);
+  if (fd >= 0) {
+    ImcFd[NumImc]    = fd;
+    ImcBytes[NumImc] = bytes;
+    NumImc++;
+  }
+}
+
+static void openMemoryCounters(void)
+{
+  DIR *dir = opendir(SYSFS_PMU);
+  if (dir == NULL) {
+    return;
+  }
+
+  struct dirent *entry;
+  while ((entry = readdir(dir)) != NULL) {
+    if (strncmp(entry->d_name, "uncore_imc", strlen("uncore_imc")) == 0) {
+      openImcEvent(entry->d_name, "cas_count_read");
+      openImcEvent(entry->d_name, "cas_count_write");
+    }
+  }
+  closedir(dir);
+}
+
+/**
+ * @brief Open the hardware counters of all threads.
+ *
+ * Every OpenMP thread opens its own counter group for the calling thread, so
+ * the counters follow the thread wherever it is pinned. Unsupported events are
+ * skipped. The memory controller counters count the whole socket and are only
+ * opened for runs with a single rank, where they can be attributed.
+ *
+ * @param c Communication structure
+ * @param numRegions Number of profiled regions
+ */
+void perfEventsInit(CommType *c, int numRegions)
+{
+#ifdef _OPENMP
+  NumThreads = omp_get_max_threads();
+#else
+  NumThreads = 1;
+#endif
+  size_t threadsSize = NumThreads * sizeof(ThreadCounters);
+  size_t countsSize  = (size_t)numRegions * NumThreads * NUMPERF * sizeof(double);
+
+  NumRegions         = numRegions;
+  Threads            = (ThreadCounters *)allocate(ARRAY_ALIGNMENT, threadsSize);
+  Counts             = (double *)allocate(ARRAY_ALIGNMENT, countsSize);
+  memset(Counts, 0, countsSize);
+
+#pragma omp parallel
+  {
+    openThreadCounters(&Threads[threadId()]);
+  }
+
+  for (int e = 0; e < NUMTHREADEVENTS; e++) {
+    Available[e] = Threads[0].fd[e] >= 0;
+  }
+
+  if (c->size == 1) {
+    openMemoryCounters();
+  }
+  Available[PERF_MEM_BYTES] = NumImc > 0;
+
+  if (commIsMaster(c)) {
+    if (Threads[0].leader < 0) {
+      printf("Warning: perf_event_open failed, no hardware counters available\n");
+    } else {
+      printf("Hardware counters:%s%s%s%s\n",
+          Available[PERF_CYCLES] ? " cycles" : "",
+          Available[PERF_INSTRUCTIONS] ? " instructions" : "",
+          Available[PERF_LLC_MISSES] ? " LLC misses" : "",
+          Available[PERF_MEM_BYTES] ? " memory bytes" : "");
+    }
+  }
+}
+
+void perfEventsStart(int region)
+{
+  int thread = threadId();
+
+  if (thread >= NumThreads) {
+    return;
+  }
+  readThreadCounters(&Threads[thread], Threads[thread].start);
+
+  if (thread == 0) {
+    for (int i = 0; i < NumImc; i++) {
+      if (read(ImcFd[i], &ImcStart[i], sizeof(uint64_t)) != sizeof(uint64_t)) {
+        ImcStart[i] = 0;
+      }
+    }
+  }
+}
+
+void perfEventsStop(int region)
+{
+  int thread = threadId();
+  uint64_t values[NUMTHREADEVENTS];
+
+  if (thread >= NumThreads) {
+    return;
+  }
+  readThreadCounters(&Threads[thread], values);
+
+  double *counts = &Counts[((size_t)region * NumThreads + thread) * NUMPERF];
+  for (int e = 0; e < NUMTHREADEVENTS; e++) {
+    counts[e] += (double)(values[e] - Threads[thread].start[e]);
+  }
+
+  if (thread == 0) {
+    for (int i = 0; i < NumImc; i++) {
+      uint64_t value;
+
+      if (read(ImcFd[i], &value, sizeof(uint64_t)) == sizeof(uint64_t)) {
+        counts[PERF_MEM_BYTES] += (double)(value - ImcStart[i]) * ImcBytes[i];
+      }
+    }
+  }
+}
+
+bool perfEventsAvailable(PerfEventType event)
+{
+  return Available[event];
+}
+
+// Sum of the counts of a region over all threads and ranks, valid on the master
+void perfEventsReduce(CommType *c, int region, double *counts)
+{
+  for (int e = 0; e < NUMPERF; e++) {
+    counts[e] = 0.0;
+    for (int t = 0; t < NumThreads; t++) {
+      counts[e] += Counts[((size_t)region * NumThreads + t) * NUMPERF + e];
+    }
+  }
+
+#ifdef _MPI
+  if (commIsMaster(c)) {
+    MPI_Reduce(MPI_IN_PLACE, counts, NUMPERF, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+  } else {
+    MPI_Reduce(counts, NULL, NUMPERF, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+  }
+#endif
+}
+
+void perfEventsFinalize(void)
+{
+  for (int t = 0; t < NumThreads; t++) {
+    for (int e = 0; e < NUMTHREADEVENTS; e++) {
+      if (Threads[t].fd[e] >= 0) {
+        close(Threads[t].fd[e]);
+      }
+    }
+  }
+  for (int i = 0; i < NumImc; i++) {
+    close(ImcFd[i]);
+  }
+
+  free(Threads);
+  free(Counts);
+  Threads    = NULL;
+  Counts     = NULL;
+  NumThreads = 0;
+  NumImc     = 0;
+}
+#endif /* PERF_EVENTS */
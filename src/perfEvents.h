@@ -0,0 +1,32 @@
+/* Copyright (C) NHR@FAU, University Erlangen-Nuremberg.
+ * All rights reserved. This file is part of SparseBench.
+ * Use of this source code is governed by a MIT style
+ * license that can be found in the LICENSE file. */
+#ifndef __PERFEVENTS_H_
+#define __PERFEVENTS_H_
+#include <stdbool.h>
+
+#include "comm.h"
+
+// Hardware counters read with perf_event_open. Cycles, instructions and last
+// level cache misses are counted per thread, memory bytes are taken from the
+// uncore memory controllers if the kernel exposes them and the run uses a
+// single rank.
+typedef enum {
+  PERF_CYCLES = 0,
+  PERF_INSTRUCTIONS,
+  PERF_LLC_MISSES,
+  PERF_MEM_BYTES,
+  NUMPERF
+} PerfEventType;
+
+#define PERF_CACHELINE 64
+
+extern void perfEventsInit(CommType *c, int numRegions);
+extern void perfEventsStart(int region);
+extern void perfEventsStop(int region);
+extern bool perfEventsAvailable(PerfEventType event);
+extern void perfEventsReduce(CommType *c, int region, double *counts);
+extern void perfEventsFinalize(void);
+
+#endif // __PERFEVENTS_H_
@@ -3,127 +3,904 @@
  * Use of this source code is governed by a MIT style
  * license that can be found in the LICENSE file. */
 #include "profiler.h"
+#include "allocate.h"
+#include "cli.h"
 #include "comm.h"
 #include "likwid-marker.h"
+#include "reorder.h"
+#include "trace.h"
 #include "util.h"
+#include <math.h>
 #include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#if defined(__clang__) || defined(__INTEL_LLVM_COMPILER)
+#define COMPILER_STRING __VERSION__
+#elif defined(__GNUC__)
+#define COMPILER_STRING "GCC " __VERSION__
+#else
+#define COMPILER_STRING "unknown"
+#endif
+
+#define LABEL_WIDTH 12
+#define SAMPLES_INITIAL 1024
+#define OUTLIER_MADS 5.0
+#define MAX_OUTLIERS_SHOWN 8
+#define HISTOGRAM_BINS 8
+#define HISTOGRAM_WIDTH 40
+
+// Walltime of every single call of a region
 typedef struct {
-  char *label;
-  size_t words;
+  size_t count, capacity;
+  double *samples;
+} SampleBuffer;
+
+// A profiled region with its work model per call, summed over all ranks
+typedef struct {
+  const char *name;
   size_t flops;
-} WorkType;
+  size_t bytes;
+  int parent; // enclosing region or NOREGION
+  int depth; // nesting level, 0 for top level regions
+  double attainable; // attainable memory bandwidth in GB/s, 0 if unknown
+  double time; // walltime of this rank summed over all calls
+  SampleBuffer samples;
+} RegionType;
+
+// Statistics over the calls of a region, an outlier takes longer than the
+// median by more than OUTLIER_MADS scaled median absolute deviations
+typedef struct {
+  size_t calls;
+  double min, median, p90, max, cv;
+  size_t outliers;
+  size_t firstOutliers[MAX_OUTLIERS_SHOWN];
+} SampleStats;
+
+// Time and work of one thread in every region summed over all calls. Only the
+// ratios between threads and ranks are reported.
+typedef struct {
+  double time[MAXREGIONS];
+  double work[MAXREGIONS];
+} ThreadSample;
+
+// Load imbalance of a region as maximum over average. The thread values are the
+// worst rank, the rank values compare the sums over the threads of the ranks.
+typedef struct {
+  double threadTime, threadWork;
+  double rankTime, rankWork;
+} ImbalanceStats;
 
-double T[NUMREGIONS];
+static RegionType Regions[MAXREGIONS];
+static int NumRegions        = 0;
+static int CommRegion        = NOREGION;
+static int NumThreads        = 1;
+static ThreadSample *Threads = NULL;
 
-static WorkType Regions[NUMREGIONS] = {
-  { "waxpby:  ", 3, 6 },
-  { "spMVM:   ", 0, 2 },
-  { "ddot:    ", 2, 4 },
-  { "comm:    ", 0, 0 }
-};
+static const char *BenchNames[NUMTYPES] = { "cg", "spmv", "gmres", "cheb", "tune" };
+static const char *MemoryPhases[NUMMEMPHASES] = { "setup",
+  "read",
+  "distribute",
+  "localize",
+  "convert",
+  "solve" };
 
-void profilerInit(size_t *facFlops, size_t *facWords)
+/**
+ * @brief Register a profiled region.
+ *
+ * The work model is given per call and summed over all ranks, rates are
+ * derived from it and the number of calls. Nested regions name their
+ * enclosing region as parent and are listed below it in all reports. All
+ * ranks have to register the same regions in the same order.
+ *
+ * @param name Region name used in reports, JSON results and traces
+ * @param flops Floating point operations per call
+ * @param bytes Memory traffic in bytes per call
+ * @param parent Enclosing region or NOREGION
+ * @return Region id to use with PROFILE
+ */
+int profilerRegister(const char *name, size_t flops, size_t bytes, int parent)
 {
-  LIKWID_MARKER_INIT;
+  if (NumRegions == MAXREGIONS) {
+    printf("Too many profiler regions, increase MAXREGIONS\n");
+    exit(EXIT_FAILURE);
+  }
+
+  RegionType *r = &Regions[NumRegions];
+  r->name       = name;
+  r->flops      = flops;
+  r->bytes      = bytes;
+  r->parent     = parent;
+  r->depth      = parent == NOREGION ? 0 : Regions[parent].depth + 1;
+  r->attainable = 0.0;
+  r->time       = 0.0;
+  r->samples    = (SampleBuffer) { 0, 0, NULL };
+
+#ifdef LIKWID_PERFMON
   _Pragma("omp parallel")
   {
-    LIKWID_MARKER_REGISTER("WAXPBY");
-    LIKWID_MARKER_REGISTER("SPMVM");
-    LIKWID_MARKER_REGISTER("DDOT");
-    LIKWID_MARKER_REGISTER("COMM");
+    LIKWID_MARKER_REGISTER(name);
   }
+#endif
+
+  return NumRegions++;
+}
 
-  for (int i = 0; i < NUMREGIONS; i++) {
-    T[i] = 0.0;
-    Regions[i].flops *= facFlops[i];
-    Regions[i].words *= facWords[i];
+const char *profilerRegionName(int region)
+{
+  return Regions[region].name;
+}
+
+void profilerSetBandwidth(int region, double bandwidth)
+{
+  Regions[region].attainable = bandwidth;
+}
+
+// The per rank walltime of this region is reported with the halo volume
+void profilerSetCommRegion(int region)
+{
+  CommRegion = region;
+}
+
+void profilerThreadSample(int tag, double start, double stop, size_t work)
+{
+  int thread = 0;
+#ifdef _OPENMP
+  thread = omp_get_thread_num();
+#endif
+  if (tag == NOREGION) {
+    return;
+  }
+  Threads[thread].time[tag] += stop - start;
+  Threads[thread].work[tag] += (double)work;
+  traceEvent(tag, start, stop);
+}
+
+void profilerSample(int tag, double start, double stop)
+{
+  if (tag == NOREGION) {
+    return;
   }
 
-  Regions[SPMVM].words = facWords[SPMVM];
+  SampleBuffer *buffer = &Regions[tag].samples;
+  double time          = stop - start;
+
+  Regions[tag].time += time;
+
+  if (buffer->count == buffer->capacity) {
+    buffer->capacity = buffer->capacity ? 2 * buffer->capacity : SAMPLES_INITIAL;
+    buffer->samples =
+        (double *)realloc(buffer->samples, buffer->capacity * sizeof(double));
+    if (buffer->samples == NULL) {
+      printf("Could not allocate profiler samples\n");
+      exit(EXIT_FAILURE);
+    }
+  }
+  buffer->samples[buffer->count++] = time;
+  traceEvent(tag, start, stop);
 }
 
-void profilerPrint(CommType *c, int iterations)
+// Append the children of parent depth first to order
+static int appendChildren(int parent, int *order, int n)
 {
+  for (int j = 0; j < NumRegions; j++) {
+    if (Regions[j].parent == parent) {
+      order[n++] = j;
+      n          = appendChildren(j, order, n);
+    }
+  }
+  return n;
+}
 
-  if (c->size > 1) {
+// Regions in report order, every region is followed by its nested regions
+static int regionOrder(int *order)
+{
+  return appendChildren(NOREGION, order, 0);
+}
+
+// Region name indented by the nesting level and padded to the label column
+static void printLabel(int region)
+{
+  char label[MAXSTRLEN];
+
+  snprintf(label,
+      sizeof(label),
+      "%*s%s:",
+      2 * Regions[region].depth,
+      "",
+      Regions[region].name);
+  printf("%-*s", LABEL_WIDTH, label);
+}
+
+static size_t regionCalls(int region)
+{
+  return Regions[region].samples.count;
+}
+
+static int compareDouble(const void *a, const void *b)
+{
+  double a_ = *(const double *)a;
+  double b_ = *(const double *)b;
+
+  return (a_ > b_) - (a_ < b_);
+}
+
+// Value at fraction q of sorted samples, nearest rank method
+static double quantile(const double *sorted, size_t n, double q)
+{
+  size_t rank = (size_t)ceil(q * n);
+
+  return sorted[rank > 0 ? rank - 1 : 0];
+}
+
+// Statistics of the call times of one region. With MPI a call is as slow as
+// the slowest rank, so the samples are reduced element wise with the maximum
+// over all ranks first. The result is valid on the master rank.
+static void sampleStats(CommType *c, int tag, SampleStats *stats)
+{
+  SampleBuffer *buffer = &Regions[tag].samples;
+  size_t n             = buffer->count;
+
+  stats->calls    = 0;
+  stats->outliers = 0;
 #ifdef _MPI
-    double tmin[NUMREGIONS];
-    double tmax[NUMREGIONS];
-    double tavg[NUMREGIONS];
+  unsigned long long count = n;
+  MPI_Allreduce(MPI_IN_PLACE, &count, 1, MPI_UNSIGNED_LONG_LONG, MPI_MIN, MPI_COMM_WORLD);
+  n = count;
+#endif
+  if (n == 0) {
+    return;
+  }
+
+  double *time = (double *)malloc(n * sizeof(double));
+  double *work = (double *)malloc(n * sizeof(double));
+#ifdef _MPI
+  MPI_Reduce(buffer->samples, time, n, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+#else
+  memcpy(time, buffer->samples, n * sizeof(double));
+#endif
+
+  if (commIsMaster(c)) {
+    double sum = 0.0;
+    double sq  = 0.0;
+
+    for (size_t i = 0; i < n; i++) {
+      work[i] = time[i];
+      sum += time[i];
+      sq += time[i] * time[i];
+    }
+    qsort(work, n, sizeof(double), compareDouble);
+
+    double mean   = sum / n;
+    stats->calls  = n;
+    stats->min    = work[0];
+    stats->median = quantile(work, n, 0.5);
+    stats->p90    = quantile(work, n, 0.9);
+    stats->max    = work[n - 1];
+    stats->cv     = mean > 0.0 ? sqrt(MAX(sq / n - mean * mean, 0.0)) / mean : 0.0;
+
+    for (size_t i = 0; i < n; i++) {
+      work[i] = fabs(time[i] - stats->median);
+    }
+    qsort(work, n, sizeof(double), compareDouble);
+
+    double threshold = stats->median + OUTLIER_MADS * 1.4826 * quantile(work, n, 0.5);
+
+    for (size_t i = 0; i < n; i++) {
+      if (time[i] > threshold) {
+        if (stats->outliers < MAX_OUTLIERS_SHOWN) {
+          stats->firstOutliers[stats->outliers] = i;
+        }
+        stats->outliers++;
+      }
+    }
+  }
+
+  free(work);
+  free(time);
+}
+
+// Per call statistics of all regions and the calls flagged as outliers
+static void printSampleStats(SampleStats *stats, int *order, int n)
+{
+  printf("%-*s%12s%12s%12s%12s%9s%10s\n",
+      LABEL_WIDTH,
+      "Per call",
+      "min(s)",
+      "median(s)",
+      "p90(s)",
+      "max(s)",
+      "CV",
+      "outliers");
+  for (int i = 0; i < n; i++) {
+    int j = order[i];
+
+    if (stats[j].calls == 0) {
+      continue;
+    }
+    printLabel(j);
+    printf(" %11.3e %11.3e %11.3e %11.3e %8.3f %9zu\n",
+        stats[j].min,
+        stats[j].median,
+        stats[j].p90,
+        stats[j].max,
+        stats[j].cv,
+        stats[j].outliers);
+  }
+
+  for (int i = 0; i < n; i++) {
+    int j = order[i];
 
-    MPI_Reduce(T, tmin, NUMREGIONS, MPI_DOUBLE, MPI_MIN, 0, MPI_COMM_WORLD);
-    MPI_Reduce(T, tmax, NUMREGIONS, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
-    MPI_Reduce(T, tavg, NUMREGIONS, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+    if (stats[j].outliers == 0) {
+      continue;
+    }
+    printf("%s outlier calls", Regions[j].name);
+    for (size_t k = 0; k < MIN(stats[j].outliers, MAX_OUTLIERS_SHOWN); k++) {
+      printf(" %zu", stats[j].firstOutliers[k]);
+    }
+    printf(stats[j].outliers > MAX_OUTLIERS_SHOWN ? " ...\n" : "\n");
+  }
+}
+
+// Region walltimes of this rank
+static void regionTimes(double *time)
+{
+  for (int j = 0; j < NumRegions; j++) {
+    time[j] = Regions[j].time;
+  }
+}
+
+// Minimum, maximum and average region times over all ranks, valid on the master
+static void reduceTimes(CommType *c, double *tmin, double *tmax, double *tavg)
+{
+  double time[MAXREGIONS];
 
-    for (int i = 0; i < NUMREGIONS; i++) {
+  regionTimes(time);
+#ifdef _MPI
+  if (c->size > 1) {
+    MPI_Reduce(time, tmin, NumRegions, MPI_DOUBLE, MPI_MIN, 0, MPI_COMM_WORLD);
+    MPI_Reduce(time, tmax, NumRegions, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+    MPI_Reduce(time, tavg, NumRegions, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+
+    for (int i = 0; i < NumRegions; i++) {
       tavg[i] /= c->size;
     }
+    return;
+  }
+#endif
+  for (int i = 0; i < NumRegions; i++) {
+    tmin[i] = time[i];
+    tmax[i] = time[i];
+    tavg[i] = time[i];
+  }
+}
+
+static double maxOverAvg(double max, double sum, int n)
+{
+  return sum > 0.0 ? max * n / sum : 0.0;
+}
+
+// Imbalance of all regions, collective and valid on the master. The thread
+// imbalance is only known with THREAD_TIMER, otherwise it is 0.
+static void imbalanceStats(CommType *c, ImbalanceStats *stats)
+{
+  double threadTime[MAXREGIONS], threadWork[MAXREGIONS];
+  double rankWork[MAXREGIONS];
+  double threadTimeMax[MAXREGIONS], threadWorkMax[MAXREGIONS];
+  double workMax[MAXREGIONS], workSum[MAXREGIONS];
+  double tmin[MAXREGIONS], tmax[MAXREGIONS], tavg[MAXREGIONS];
+
+  for (int j = 0; j < NumRegions; j++) {
+    double maxTime = 0.0, sumTime = 0.0;
+    double maxWork = 0.0, sumWork = 0.0;
+
+    for (int t = 0; t < NumThreads; t++) {
+      maxTime = MAX(maxTime, Threads[t].time[j]);
+      maxWork = MAX(maxWork, Threads[t].work[j]);
+      sumTime += Threads[t].time[j];
+      sumWork += Threads[t].work[j];
+    }
+    threadTime[j] = maxOverAvg(maxTime, sumTime, NumThreads);
+    threadWork[j] = maxOverAvg(maxWork, sumWork, NumThreads);
+    rankWork[j]   = sumWork;
+  }
+
+  reduceTimes(c, tmin, tmax, tavg);
+#ifdef _MPI
+  MPI_Reduce(threadTime,
+      threadTimeMax,
+      NumRegions,
+      MPI_DOUBLE,
+      MPI_MAX,
+      0,
+      MPI_COMM_WORLD);
+  MPI_Reduce(threadWork,
+      threadWorkMax,
+      NumRegions,
+      MPI_DOUBLE,
+      MPI_MAX,
+      0,
+      MPI_COMM_WORLD);
+  MPI_Reduce(rankWork, workMax, NumRegions, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+  MPI_Reduce(rankWork, workSum, NumRegions, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+#else
+  for (int j = 0; j < NumRegions; j++) {
+    threadTimeMax[j] = threadTime[j];
+    threadWorkMax[j] = threadWork[j];
+    workMax[j]       = rankWork[j];
+    workSum[j]       = rankWork[j];
+  }
+#endif
+
+  for (int j = 0; j < NumRegions; j++) {
+    stats[j].threadTime = threadTimeMax[j];
+    stats[j].threadWork = threadWorkMax[j];
+    stats[j].rankTime   = tavg[j] > 0.0 ? tmax[j] / tavg[j] : 0.0;
+    stats[j].rankWork   = maxOverAvg(workMax[j], workSum[j], c->size);
+  }
+}
+
+#if defined(_MPI) || defined(THREAD_TIMER)
+// Imbalance factor column, unknown values are shown as -
+static void printFactor(double factor)
+{
+  if (factor > 0.0) {
+    printf(" %11.3f", factor);
+  } else {
+    printf(" %11s", "-");
+  }
+}
+
+static void printImbalance(ImbalanceStats *stats, int *order, int n)
+{
+  printf("Imbalance max/avg\n");
+  printf("%-*s%12s%12s%12s%12s\n",
+      LABEL_WIDTH,
+      "Function",
+      "thread time",
+      "thread work",
+      "rank time",
+      "rank work");
+  for (int i = 0; i < n; i++) {
+    int j = order[i];
+
+    if (regionCalls(j) == 0) {
+      continue;
+    }
+    printLabel(j);
+    printFactor(stats[j].threadTime);
+    printFactor(stats[j].threadWork);
+    printFactor(stats[j].rankTime);
+    printFactor(stats[j].rankWork);
+    printf("\n");
+  }
+}
+#endif
+
+#ifdef _MPI
+// Histogram of the region walltimes of all ranks, times is [rank][region]
+static void printRankHistogram(double *times, int size, int *order, int n)
+{
+  for (int i = 0; i < n; i++) {
+    int j       = order[i];
+    double tmin = times[j];
+    double tmax = times[j];
+
+    for (int r = 1; r < size; r++) {
+      tmin = MIN(tmin, times[r * MAXREGIONS + j]);
+      tmax = MAX(tmax, times[r * MAXREGIONS + j]);
+    }
+    if (tmax <= 0.0) {
+      continue;
+    }
+
+    int bins                  = MIN(HISTOGRAM_BINS, size);
+    int count[HISTOGRAM_BINS] = { 0 };
+    int maxCount              = 0;
+    double width              = (tmax - tmin) / bins;
+
+    for (int r = 0; r < size; r++) {
+      int bin = width > 0.0 ? (int)((times[r * MAXREGIONS + j] - tmin) / width) : 0;
+      bin     = MIN(bin, bins - 1);
+      count[bin]++;
+      maxCount = MAX(maxCount, count[bin]);
+    }
+
+    printf("%s ranks over walltime(s)\n", Regions[j].name);
+    for (int b = 0; b < bins; b++) {
+      printf("  %10.3e - %10.3e %6d ",
+          tmin + b * width,
+          tmin + (b + 1) * width,
+          count[b]);
+      for (int k = 0; k < count[b] * HISTOGRAM_WIDTH / maxCount; k++) {
+        printf("#");
+      }
+      printf("\n");
+      if (width <= 0.0) {
+        break;
+      }
+    }
+  }
+}
+#endif
+
+// Number of vector elements sent and received by this rank in one exchange
+static int exchangeWords(CommType *c)
+{
+  int commWords = 0;
+#ifdef _MPI
+  for (int i = 0; i < c->outdegree; i++) {
+    commWords += c->sendCounts[i];
+  }
+  for (int i = 0; i < c->indegree; i++) {
+    commWords += c->recvCounts[i];
+  }
+#endif
+  return commWords;
+}
+
+static void jsonString(FILE *fp, const char *str)
+{
+  fputc('"', fp);
+  for (; *str != '\0'; str++) {
+    if (*str == '"' || *str == '\\') {
+      fprintf(fp, "\\%c", *str);
+    } else if ((unsigned char)*str < 0x20) {
+      fprintf(fp, "\\u%04x", *str);
+    } else {
+      fputc(*str, fp);
+    }
+  }
+  fputc('"', fp);
+}
+
+/**
+ * @brief Initialize the profiler.
+ *
+ * Must be called before regions are registered. All registered regions are
+ * dropped.
+ *
+ * @param c Communication structure, used to set up the hardware counters
+ */
+void profilerInit(CommType *c)
+{
+  LIKWID_MARKER_INIT;
+
+  NumRegions = 0;
+  CommRegion = NOREGION;
 
-    int commWords = 0;
-    for (int i = 0; i < c->outdegree; i++) {
-      commWords += c->sendCounts[i];
+#ifdef _OPENMP
+  NumThreads = omp_get_max_threads();
+#endif
+  free(Threads);
+  Threads = (ThreadSample *)allocate(ARRAY_ALIGNMENT, NumThreads * sizeof(ThreadSample));
+  memset(Threads, 0, NumThreads * sizeof(ThreadSample));
+#ifdef PERF_EVENTS
+  perfEventsInit(c, MAXREGIONS);
+#else
+  (void)c; // only the hardware counters depend on the ranks
+#endif
+}
+
+// Drop all measurements, e.g. of warmup calls. Traces are kept.
+void profilerReset(void)
+{
+  for (int j = 0; j < NumRegions; j++) {
+    Regions[j].time          = 0.0;
+    Regions[j].samples.count = 0;
+  }
+  memset(Threads, 0, NumThreads * sizeof(ThreadSample));
+}
+
+#ifdef PERF_EVENTS
+// Hardware counter sums of all regions over threads and ranks, collective
+static void reduceCounters(CommType *c, double counts[MAXREGIONS][NUMPERF])
+{
+  for (int j = 0; j < NumRegions; j++) {
+    perfEventsReduce(c, j, counts[j]);
+  }
+}
+
+// Memory bytes of a region, estimated from LLC misses without memory counters
+static double memoryBytes(double *counts)
+{
+  if (perfEventsAvailable(PERF_MEM_BYTES)) {
+    return counts[PERF_MEM_BYTES];
+  }
+  return counts[PERF_LLC_MISSES] * PERF_CACHELINE;
+}
+
+// Measured memory bytes per flop, to compare with the modelled code balance
+static double bytesPerFlop(int region, double *counts)
+{
+  double flops = (double)regionCalls(region) * Regions[region].flops;
+
+  return flops > 0.0 ? memoryBytes(counts) / flops : 0.0;
+}
+
+static void printCounters(double counts[MAXREGIONS][NUMPERF], int *order, int n)
+{
+  if (!perfEventsAvailable(PERF_CYCLES) && !perfEventsAvailable(PERF_INSTRUCTIONS)) {
+    return;
+  }
+
+  printf("%-*s%12s%12s%8s%12s%12s%8s\n",
+      LABEL_WIDTH,
+      "Counters",
+      "cycles",
+      "instr",
+      "IPC",
+      "LLC misses",
+      "memory(B)",
+      "B/Flop");
+  for (int i = 0; i < n; i++) {
+    int j         = order[i];
+    double *count = counts[j];
+
+    if (count[PERF_CYCLES] == 0.0 && count[PERF_INSTRUCTIONS] == 0.0) {
+      continue;
     }
-    for (int i = 0; i < c->indegree; i++) {
-      commWords += c->recvCounts[i];
+    printLabel(j);
+    printf(" %11.3e %11.3e %7.2f %11.3e %11.3e",
+        count[PERF_CYCLES],
+        count[PERF_INSTRUCTIONS],
+        count[PERF_CYCLES] > 0.0 ? count[PERF_INSTRUCTIONS] / count[PERF_CYCLES] : 0.0,
+        count[PERF_LLC_MISSES],
+        memoryBytes(count));
+    if (Regions[j].flops > 0) {
+      printf(" %7.2f", bytesPerFlop(j, count));
     }
+    printf("\n");
+  }
+  if (!perfEventsAvailable(PERF_MEM_BYTES)) {
+    printf("Memory bytes estimated as LLC misses x %d B\n", PERF_CACHELINE);
+  }
+}
+#endif
+
+// Rate of a work model in units per second for all calls of a region
+static double regionRate(int region, size_t perCall, double time)
+{
+  if (time <= 0.0) {
+    return 0.0;
+  }
+  return (double)perCall * regionCalls(region) / time;
+}
+
+// Code balance of the traffic model in bytes per flop
+static double codeBalance(int region)
+{
+  return (double)Regions[region].bytes / Regions[region].flops;
+}
+
+// Rate in MFlop/s predicted by the roofline model from the attainable
+// bandwidth and the code balance of the region
+static double regionRoofline(int region)
+{
+  return 1.0E03 * Regions[region].attainable / codeBalance(region);
+}
+
+// Traffic model of all regions doing flops and, if the attainable bandwidth is
+// known, the achieved fraction of it and the roofline limit
+static void printRoofline(double *time, int *order, int n)
+{
+  bool attainable = false;
+
+  printf("%-*s%12s%12s\n", LABEL_WIDTH, "Model", "MB/call", "B/Flop");
+  for (int i = 0; i < n; i++) {
+    int j = order[i];
+
+    if (regionCalls(j) == 0 || Regions[j].flops == 0) {
+      continue;
+    }
+    printLabel(j);
+    printf(" %11.2f %11.2f\n", 1.0E-06 * Regions[j].bytes, codeBalance(j));
+    attainable = attainable || Regions[j].attainable > 0.0;
+  }
+
+  if (!attainable) {
+    return;
+  }
+
+  printf("%-*s%12s%12s%12s%12s%12s\n",
+      LABEL_WIDTH,
+      "Roofline",
+      "GB/s attain",
+      "GB/s",
+      "% attain",
+      "MFlop/s pred",
+      "MFlop/s");
+  for (int i = 0; i < n; i++) {
+    int j = order[i];
+
+    if (regionCalls(j) == 0 || Regions[j].flops == 0 || Regions[j].attainable <= 0.0) {
+      continue;
+    }
+
+    double achieved = 1.0E-09 * regionRate(j, Regions[j].bytes, time[j]);
+
+    printLabel(j);
+    printf(" %11.2f %11.2f %11.1f %11.2f %11.2f\n",
+        Regions[j].attainable,
+        achieved,
+        100.0 * achieved / Regions[j].attainable,
+        regionRoofline(j),
+        1.0E-06 * regionRate(j, Regions[j].flops, time[j]));
+  }
+}
+
+// Bandwidth and profile of the local blocks, see reorderMatrix
+static void printReorderStats(void)
+{
+  if (!ReordStats.valid) {
+    return;
+  }
+
+  printf("Reordering       original   reordered\n");
+  printf("Bandwidth      %11lld %11lld\n",
+      ReordStats.bandwidth[0],
+      ReordStats.bandwidth[1]);
+  printf("Profile        %11lld %11lld\n", ReordStats.profile[0], ReordStats.profile[1]);
+}
+
+void profilerPrint(CommType *c)
+{
+  int order[MAXREGIONS];
+  int n = regionOrder(order);
+
+  if (c->size > 1) {
+#ifdef _MPI
+    double tmin[MAXREGIONS];
+    double tmax[MAXREGIONS];
+    double tavg[MAXREGIONS];
+
+    reduceTimes(c, tmin, tmax, tavg);
+
+    SampleStats stats[MAXREGIONS];
+    for (int j = 0; j < NumRegions; j++) {
+      sampleStats(c, j, &stats[j]);
+    }
+#ifdef PERF_EVENTS
+    double counts[MAXREGIONS][NUMPERF];
+    reduceCounters(c, counts);
+#endif
+    ImbalanceStats imbalance[MAXREGIONS];
+    imbalanceStats(c, imbalance);
 
-    Regions[COMM].words = sizeof(CG_FLOAT) * commWords;
+    double time[MAXREGIONS];
+    double rankTimes[c->size * MAXREGIONS];
+    regionTimes(time);
+    MPI_Gather(time,
+        MAXREGIONS,
+        MPI_DOUBLE,
+        rankTimes,
+        MAXREGIONS,
+        MPI_DOUBLE,
+        0,
+        MPI_COMM_WORLD);
+
+    int commWords = exchangeWords(c);
     int commVolume[c->size];
     MPI_Gather(&commWords, 1, MPI_INT, commVolume, 1, MPI_INT, 0, MPI_COMM_WORLD);
-    double commTime[c->size];
-    MPI_Gather(&T[COMM], 1, MPI_DOUBLE, commTime, 1, MPI_DOUBLE, 0, MPI_COMM_WORLD);
 
     if (commIsMaster(c)) {
       printf(HLINE);
-      printf("Function   avg MB/s  avg MFlop/s  Walltime(s) min, max, avg\n");
-      for (int j = 0; j < NUMREGIONS - 1; j++) {
-        double bytes = (double)Regions[j].words * iterations;
-        double flops = (double)Regions[j].flops * iterations;
-
-        printf("%s%11.2f %11.2f %11.2f %11.2f %11.2f\n",
-            Regions[j].label,
-            1.0E-06 * bytes / tavg[j],
-            1.0E-06 * flops / tavg[j],
+      printf("%-*s%12s%12s%12s%12s%12s\n",
+          LABEL_WIDTH,
+          "Function",
+          "avg MB/s",
+          "avg MFlop/s",
+          "min time(s)",
+          "max time(s)",
+          "avg time(s)");
+      for (int i = 0; i < n; i++) {
+        int j = order[i];
+
+        if (regionCalls(j) == 0) {
+          continue;
+        }
+        printLabel(j);
+        printf(" %11.2f %11.2f %11.2f %11.2f %11.2f\n",
+            1.0E-06 * regionRate(j, Regions[j].bytes, tavg[j]),
+            1.0E-06 * regionRate(j, Regions[j].flops, tavg[j]),
             tmin[j],
             tmax[j],
             tavg[j]);
       }
+      printRoofline(tavg, order, n);
+      printSampleStats(stats, order, n);
+#ifdef PERF_EVENTS
+      printCounters(counts, order, n);
+#endif
+      printImbalance(imbalance, order, n);
+      printRankHistogram(rankTimes, c->size, order, n);
       printf(HLINE);
       double totalVolume = 0.0;
       printf("Communication\n");
       printf("rank\tkB\tkB/s\tWalltime(s)\n");
       for (int i = 0; i < c->size; i++) {
-        double dataVolume = 1.0E-03 * commVolume[i];
+        double dataVolume = 1.0E-03 * sizeof(CG_FLOAT) * commVolume[i];
+        double commTime   = 0.0;
+
+        if (CommRegion != NOREGION) {
+          commTime = rankTimes[i * MAXREGIONS + CommRegion];
+        }
         printf("%d %11.2f %11.2f %11.2e\n",
             i,
             dataVolume,
-            dataVolume / commTime[i],
-            commTime[i]);
-        totalVolume += commVolume[i];
+            commTime > 0.0 ? dataVolume / commTime : 0.0,
+            commTime);
+        totalVolume += dataVolume;
       }
 
-      printf("Total data volume %.2f kB\n", 1.0E-03 * totalVolume);
-      printf("Walltime(s): min %.2e s, max %.2e s, avg %.2e s\n",
-          tmin[COMM],
-          tmax[COMM],
-          tavg[COMM]);
+      printf("Total data volume %.2f kB\n", totalVolume);
+      if (CommRegion != NOREGION) {
+        printf("Walltime(s): min %.2e s, max %.2e s, avg %.2e s\n",
+            tmin[CommRegion],
+            tmax[CommRegion],
+            tavg[CommRegion]);
+      }
+      if (PartStats.valid) {
+        printf("Partitioning     block rows     graph\n");
+        printf("Cut edges      %11lld %11lld\n",
+            PartStats.cutEdges[0],
+            PartStats.cutEdges[1]);
+        printf("Max neighbors  %11d %11d\n",
+            PartStats.maxNeighbors[0],
+            PartStats.maxNeighbors[1]);
+        printf("Avg neighbors  %11.2f %11.2f\n",
+            PartStats.avgNeighbors[0],
+            PartStats.avgNeighbors[1]);
+      }
+      printReorderStats();
       printf(HLINE);
     }
 #endif
   } else {
+    double time[MAXREGIONS];
+
+    regionTimes(time);
     printf(HLINE);
-    printf("Function   Rate(MB/s)  Rate(MFlop/s)  Walltime(s)\n");
-    for (int j = 0; j < NUMREGIONS - 1; j++) {
-      double bytes = (double)Regions[j].words * iterations;
-      double flops = (double)Regions[j].flops * iterations;
+    printf("%-*s%12s%12s%12s\n",
+        LABEL_WIDTH,
+        "Function",
+        "MB/s",
+        "MFlop/s",
+        "Walltime(s)");
+    for (int i = 0; i < n; i++) {
+      int j = order[i];
+
+      if (regionCalls(j) == 0) {
+        continue;
+      }
+      printLabel(j);
+      printf(" %11.2f %11.2f %11.2f\n",
+          1.0E-06 * regionRate(j, Regions[j].bytes, time[j]),
+          1.0E-06 * regionRate(j, Regions[j].flops, time[j]),
+          time[j]);
+    }
+    printRoofline(time, order, n);
 
-      printf("%s%11.2f %11.2f %11.2f\n",
-          Regions[j].label,
-          1.0E-06 * bytes / T[j],
-          1.0E-06 * flops / T[j],
-          T[j]);
+    SampleStats stats[MAXREGIONS];
+    for (int j = 0; j < NumRegions; j++) {
+      sampleStats(c, j, &stats[j]);
     }
+    printSampleStats(stats, order, n);
+#ifdef PERF_EVENTS
+    double counts[MAXREGIONS][NUMPERF];
+    reduceCounters(c, counts);
+    printCounters(counts, order, n);
+#endif
+#ifdef THREAD_TIMER
+    ImbalanceStats imbalance[MAXREGIONS];
+    imbalanceStats(c, imbalance);
+    printImbalance(imbalance, order, n);
+#endif
+    printReorderStats();
     printf(HLINE);
   }
 }
@@ -131,4 +908,336 @@ void profilerPrint(CommType *c, int iterations)
 void profilerFinalize(void)
 {
   LIKWID_MARKER_CLOSE;
+#ifdef PERF_EVENTS
+  perfEventsFinalize();
+#endif
+
+  for (int j = 0; j < NumRegions; j++) {
+    free(Regions[j].samples.samples);
+    Regions[j].samples = (SampleBuffer) { 0, 0, NULL };
+  }
+  free(Threads);
+  Threads = NULL;
+  traceFinalize();
+}
+
+// Memory statistics of all phases as maximum over the ranks together with the
+// peak resident set size summed over the ranks, valid on the master
+static void reduceMemory(MemoryStats *max, double *peakSum)
+{
+  MemoryStats stats[NUMMEMPHASES];
+  double local[4 * NUMMEMPHASES];
+  double global[4 * NUMMEMPHASES];
+  double peak[NUMMEMPHASES];
+
+  allocateStats(stats);
+  for (int i = 0; i < NUMMEMPHASES; i++) {
+    local[4 * i]     = (double)stats[i].allocated;
+    local[4 * i + 1] = (double)stats[i].allocations;
+    local[4 * i + 2] = (double)stats[i].peakResident;
+    local[4 * i + 3] = (double)stats[i].resident;
+    peak[i]          = (double)stats[i].peakResident;
+  }
+#ifdef _MPI
+  MPI_Reduce(local, global, 4 * NUMMEMPHASES, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+  MPI_Reduce(peak, peakSum, NUMMEMPHASES, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+#else
+  memcpy(global, local, sizeof(local));
+  memcpy(peakSum, peak, sizeof(peak));
+#endif
+  for (int i = 0; i < NUMMEMPHASES; i++) {
+    max[i].allocated    = (size_t)global[4 * i];
+    max[i].allocations  = (size_t)global[4 * i + 1];
+    max[i].peakResident = (size_t)global[4 * i + 2];
+    max[i].resident     = (size_t)global[4 * i + 3];
+  }
+}
+
+/**
+ * @brief Print the memory footprint of the setup phases and the matrix.
+ *
+ * Collective call. For every phase the bytes requested with allocate, the peak
+ * resident set size during the phase and the resident set size at its end are
+ * shown as maximum over the ranks, the peak is also summed over the ranks. The
+ * matrix footprint is given in bytes per non zero of the benchmarked format.
+ *
+ * @param c Communication structure
+ * @param m Benchmarked matrix
+ */
+void profilerPrintMemory(CommType *c, Matrix *m)
+{
+  MemoryStats stats[NUMMEMPHASES];
+  double peakSum[NUMMEMPHASES];
+  size_t bytes = matrixBytes(m);
+
+  reduceMemory(stats, peakSum);
+  commReduceSum(&bytes);
+
+  if (!commIsMaster(c)) {
+    return;
+  }
+
+  printf("%-*s%12s%12s%12s%12s\n",
+      LABEL_WIDTH,
+      "Memory",
+      "alloc(MB)",
+      "peak(MB)",
+      "end(MB)",
+      "peak sum");
+  for (int i = 0; i < NUMMEMPHASES; i++) {
+    char label[MAXSTRLEN];
+
+    snprintf(label, sizeof(label), "%s:", MemoryPhases[i]);
+    printf("%-*s %11.2f %11.2f %11.2f %11.2f\n",
+        LABEL_WIDTH,
+        label,
+        1.0E-06 * stats[i].allocated,
+        1.0E-06 * stats[i].peakResident,
+        1.0E-06 * stats[i].resident,
+        1.0E-06 * peakSum[i]);
+  }
+  printf("Matrix %s %.2f MB, %.2f B/nnz\n",
+      matrixFormatName(m->format),
+      1.0E-06 * bytes,
+      (double)bytes / m->totalNnz);
+  printf(HLINE);
+}
+
+/**
+ * @brief Write the timeline of all profiled regions as Chrome trace JSON.
+ *
+ * Collective call, only has an effect if traceInit was called before.
+ *
+ * @param c Communication structure
+ * @param filename Output file name
+ */
+void profilerWriteTrace(CommType *c, char *filename)
+{
+  const char *names[MAXREGIONS];
+
+  if (!traceEnabled()) {
+    return;
+  }
+
+  for (int j = 0; j < NumRegions; j++) {
+    names[j] = Regions[j].name;
+  }
+
+  traceWrite(c, filename, names);
+}
+
+/**
+ * @brief Write the benchmark results as one JSON document.
+ *
+ * Collective call, the master rank writes the file. The document contains the
+ * build configuration, the matrix, the iteration count, the per region timings
+ * with bandwidth and flop rates and the per rank communication volume.
+ *
+ * @param c Communication structure
+ * @param p Parameters, p->json is the output file name
+ * @param m Benchmarked matrix
+ * @param iterations Number of performed iterations
+ */
+void profilerWriteJson(CommType *c, Parameter *p, Matrix *m, int iterations)
+{
+  double tmin[MAXREGIONS];
+  double tmax[MAXREGIONS];
+  double tavg[MAXREGIONS];
+  int commWords = exchangeWords(c);
+  int commVolume[c->size];
+  double commTime[c->size];
+  double time   = CommRegion != NOREGION ? Regions[CommRegion].time : 0.0;
+  int order[MAXREGIONS];
+  int n = regionOrder(order);
+
+  SampleStats stats[MAXREGIONS];
+  ImbalanceStats imbalance[MAXREGIONS];
+  MemoryStats memory[NUMMEMPHASES];
+  double peakSum[NUMMEMPHASES];
+  size_t matrix = matrixBytes(m);
+
+  reduceMemory(memory, peakSum);
+  commReduceSum(&matrix);
+  reduceTimes(c, tmin, tmax, tavg);
+  imbalanceStats(c, imbalance);
+  for (int j = 0; j < NumRegions; j++) {
+    sampleStats(c, j, &stats[j]);
+  }
+#ifdef PERF_EVENTS
+  double counts[MAXREGIONS][NUMPERF];
+  reduceCounters(c, counts);
+#endif
+#ifdef _MPI
+  MPI_Gather(&commWords, 1, MPI_INT, commVolume, 1, MPI_INT, 0, MPI_COMM_WORLD);
+  MPI_Gather(&time, 1, MPI_DOUBLE, commTime, 1, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+#else
+  commVolume[0] = commWords;
+  commTime[0]   = time;
+#endif
+
+  if (!commIsMaster(c)) {
+    return;
+  }
+
+  FILE *fp = fopen(p->json, "w");
+  if (fp == NULL) {
+    printf("Warning: Could not open JSON output file %s\n", p->json);
+    return;
+  }
+
+  int threads = 1;
+#ifdef _OPENMP
+  threads = omp_get_max_threads();
+#endif
+
+  fprintf(fp, "{\n  \"config\": {\n");
+  fprintf(fp, "    \"format\": \"%s\",\n", matrixFormatName(m->format));
+  fprintf(fp, "    \"precision\": \"%s\",\n", PRECISION_STRING);
+  fprintf(fp, "    \"index_type\": \"%s\",\n", UINT_STRING);
+  fprintf(fp, "    \"compiler\": ");
+  jsonString(fp, COMPILER_STRING);
+#ifdef _MPI
+  fprintf(fp, ",\n    \"mpi\": true,\n");
+#else
+  fprintf(fp, ",\n    \"mpi\": false,\n");
+#endif
+  fprintf(fp, "    \"ranks\": %d,\n", c->size);
+#ifdef _OPENMP
+  fprintf(fp, "    \"openmp\": true,\n");
+#else
+  fprintf(fp, "    \"openmp\": false,\n");
+#endif
+  fprintf(fp, "    \"threads\": %d\n  },\n", threads);
+
+  fprintf(fp, "  \"matrix\": {\n    \"source\": ");
+  jsonString(fp, p->filename);
+  fprintf(fp, ",\n    \"rows\": %lld,\n", (long long)m->totalNr);
+  fprintf(fp, "    \"nnz\": %lld,\n", (long long)m->totalNnz);
+  fprintf(fp, "    \"distribution\": ");
+  jsonString(fp, p->distribution);
+  fprintf(fp, ",\n    \"reorder\": ");
+  jsonString(fp, p->reorder);
+  fprintf(fp, ",\n    \"C\": %d,\n    \"sigma\": %d\n  },\n", p->C, p->sigma);
+
+  fprintf(fp, "  \"benchmark\": \"%s\",\n", BenchNames[BenchType]);
+  fprintf(fp, "  \"iterations\": %d,\n", iterations);
+
+  fprintf(fp, "  \"regions\": [\n");
+  for (int i = 0; i < n; i++) {
+    int j           = order[i];
+    bool flops      = Regions[j].flops > 0;
+    const char *sep = i < n - 1 ? "," : "";
+
+    fprintf(fp, "    { \"name\": ");
+    jsonString(fp, Regions[j].name);
+    fprintf(fp, ", \"parent\": ");
+    if (Regions[j].parent == NOREGION) {
+      fprintf(fp, "null");
+    } else {
+      jsonString(fp, Regions[Regions[j].parent].name);
+    }
+    fprintf(fp,
+        ", \"flops_per_call\": %zu, \"bytes_per_call\": %zu, \"code_balance\": %e, "
+        "\"time_min\": %e, \"time_max\": %e, \"time_avg\": %e, \"mbytes_per_s\": %e, "
+        "\"mflops_per_s\": %e, \"attainable_gbytes_per_s\": %e, "
+        "\"roofline_mflops_per_s\": %e, \"calls\": %zu, \"call_min\": %e, "
+        "\"call_median\": %e, \"call_p90\": %e, \"call_max\": %e, \"call_cv\": %e, "
+        "\"outliers\": %zu, \"imbalance_threads\": %e, \"imbalance_thread_work\": %e, "
+        "\"imbalance_ranks\": %e, \"imbalance_rank_work\": %e }%s\n",
+        Regions[j].flops,
+        Regions[j].bytes,
+        flops ? codeBalance(j) : 0.0,
+        tmin[j],
+        tmax[j],
+        tavg[j],
+        1.0E-06 * regionRate(j, Regions[j].bytes, tavg[j]),
+        1.0E-06 * regionRate(j, Regions[j].flops, tavg[j]),
+        Regions[j].attainable,
+        flops ? regionRoofline(j) : 0.0,
+        stats[j].calls,
+        stats[j].calls ? stats[j].min : 0.0,
+        stats[j].calls ? stats[j].median : 0.0,
+        stats[j].calls ? stats[j].p90 : 0.0,
+        stats[j].calls ? stats[j].max : 0.0,
+        stats[j].calls ? stats[j].cv : 0.0,
+        stats[j].outliers,
+        imbalance[j].threadTime,
+        imbalance[j].threadWork,
+        imbalance[j].rankTime,
+        imbalance[j].rankWork,
+        sep);
+  }
+  fprintf(fp, "  ],\n");
+
+  fprintf(fp, "  \"communication\": [\n");
+  for (int i = 0; i < c->size; i++) {
+    fprintf(fp,
+        "    { \"rank\": %d, \"bytes\": %zu, \"time\": %e }%s\n",
+        i,
+        sizeof(CG_FLOAT) * commVolume[i],
+        commTime[i],
+        i < c->size - 1 ? "," : "");
+  }
+  fprintf(fp, "  ],\n");
+
+  fprintf(fp, "  \"memory\": {\n    \"matrix_bytes\": %zu,\n", matrix);
+  fprintf(fp, "    \"matrix_bytes_per_nnz\": %e,\n", (double)matrix / m->totalNnz);
+  fprintf(fp, "    \"phases\": [\n");
+  for (int i = 0; i < NUMMEMPHASES; i++) {
+    fprintf(fp,
+        "      { \"name\": \"%s\", \"allocated_bytes\": %zu, \"allocations\": %zu, "
+        "\"peak_resident_bytes\": %zu, \"resident_bytes\": %zu, "
+        "\"peak_resident_bytes_sum\": %.0f }%s\n",
+        MemoryPhases[i],
+        memory[i].allocated,
+        memory[i].allocations,
+        memory[i].peakResident,
+        memory[i].resident,
+        peakSum[i],
+        i < NUMMEMPHASES - 1 ? "," : "");
+  }
+  fprintf(fp, "    ]\n  }");
+
+#ifdef PERF_EVENTS
+  fprintf(fp, ",\n  \"counters\": [\n");
+  for (int i = 0; i < n; i++) {
+    int j = order[i];
+
+    fprintf(fp,
+        "    { \"name\": \"%s\", \"cycles\": %.0f, \"instructions\": %.0f, "
+        "\"llc_misses\": %.0f, \"memory_bytes\": %.0f, \"memory_measured\": %s }%s\n",
+        Regions[j].name,
+        counts[j][PERF_CYCLES],
+        counts[j][PERF_INSTRUCTIONS],
+        counts[j][PERF_LLC_MISSES],
+        memoryBytes(counts[j]),
+        perfEventsAvailable(PERF_MEM_BYTES) ? "true" : "false",
+        i < n - 1 ? "," : "");
+  }
+  fprintf(fp, "  ]");
+#endif
+
+  if (PartStats.valid) {
+    fprintf(fp,
+        ",\n  \"partitioning\": { \"cut_edges\": [%lld, %lld], "
+        "\"max_neighbors\": [%d, %d], \"avg_neighbors\": [%.2f, %.2f] }",
+        PartStats.cutEdges[0],
+        PartStats.cutEdges[1],
+        PartStats.maxNeighbors[0],
+        PartStats.maxNeighbors[1],
+        PartStats.avgNeighbors[0],
+        PartStats.avgNeighbors[1]);
+  }
+  if (ReordStats.valid) {
+    fprintf(fp,
+        ",\n  \"reordering\": { \"bandwidth\": [%lld, %lld], \"profile\": [%lld, %lld] }",
+        ReordStats.bandwidth[0],
+        ReordStats.bandwidth[1],
+        ReordStats.profile[0],
+        ReordStats.profile[1]);
+  }
+  fprintf(fp, "\n}\n");
+
+  FCLOSE(fp);
+  printf("Wrote results to %s\n", p->json);
 }
@@ -5,32 +5,76 @@
 #ifndef __PROFILER_H_
 #define __PROFILER_H_
 #include "comm.h"
+#include "perfEvents.h"
 #include <stddef.h>
 
 #ifdef LIKWID_PERFMON
 #define PROFILE(tag, call)                                                               \
   _Pragma("omp parallel")                                                                \
   {                                                                                      \
-    LIKWID_MARKER_START(#tag);                                                           \
+    LIKWID_MARKER_START(profilerRegionName(tag));                                        \
   }                                                                                      \
   ts = getTimeStamp();                                                                   \
   call;                                                                                  \
-  T[tag] += (getTimeStamp() - ts);                                                       \
+  profilerSample(tag, ts, getTimeStamp());                                               \
   _Pragma("omp parallel")                                                                \
   {                                                                                      \
-    LIKWID_MARKER_STOP(#tag);                                                            \
+    LIKWID_MARKER_STOP(profilerRegionName(tag));                                         \
+  }
+#elif defined(PERF_EVENTS)
+#define PROFILE(tag, call)                                                               \
+  _Pragma("omp parallel")                                                                \
+  {                                                                                      \
+    perfEventsStart(tag);                                                                \
+  }                                                                                      \
+  ts = getTimeStamp();                                                                   \
+  call;                                                                                  \
+  profilerSample(tag, ts, getTimeStamp());                                               \
+  _Pragma("omp parallel")                                                                \
+  {                                                                                      \
+    perfEventsStop(tag);                                                                 \
   }
 #else /* LIKWID_PERFMON */
 #define PROFILE(tag, call)                                                               \
   ts = getTimeStamp();                                                                   \
   call;                                                                                  \
-  T[tag] += (getTimeStamp() - ts);
+  profilerSample(tag, ts, getTimeStamp());
 #endif /* LIKWID_PERFMON */
 
-typedef enum { WAXPBY = 0, SPMVM, DDOT, COMM, NUMREGIONS } RegionsType;
+// Per thread timing inside the OpenMP parallel kernels. THREAD_TIMER_START opens
+// the measurement at the begin of the parallel region, THREAD_TIMER_WORK counts
+// the work items (non zeros or vector elements) of the thread and
+// THREAD_TIMER_STOP records both after the worksharing loop, which must be
+// nowait so the time of a thread does not include waiting for the others.
+#ifdef THREAD_TIMER
+#define THREAD_TIMER_START                                                               \
+  double threadTs   = getTimeStamp();                                                    \
+  size_t threadWork = 0
+#define THREAD_TIMER_WORK(n) threadWork += (n)
+#define THREAD_TIMER_STOP(tag)                                                           \
+  profilerThreadSample(tag, threadTs, getTimeStamp(), threadWork)
+#else /* THREAD_TIMER */
+#define THREAD_TIMER_START
+#define THREAD_TIMER_WORK(n)
+#define THREAD_TIMER_STOP(tag)
+#endif /* THREAD_TIMER */
+
+// Regions are registered at runtime with their work model, nested regions name
+// the enclosing region as parent. Samples with NOREGION are ignored.
+#define MAXREGIONS 32
+#define NOREGION -1
 
-extern double T[NUMREGIONS];
-extern void profilerInit(size_t *facFlops, size_t *facWords);
-extern void profilerPrint(CommType *c, int iterations);
+extern int profilerRegister(const char *name, size_t flops, size_t bytes, int parent);
+extern const char *profilerRegionName(int region);
+extern void profilerSetBandwidth(int region, double bandwidth);
+extern void profilerSetCommRegion(int region);
+extern void profilerSample(int tag, double start, double stop);
+extern void profilerThreadSample(int tag, double start, double stop, size_t work);
+extern void profilerInit(CommType *c);
+extern void profilerReset(void);
+extern void profilerPrint(CommType *c);
+extern void profilerPrintMemory(CommType *c, Matrix *m);
+extern void profilerWriteJson(CommType *c, Parameter *p, Matrix *m, int iterations);
+extern void profilerWriteTrace(CommType *c, char *filename);
 extern void profilerFinalize(void);
 #endif // __PROFILER_H
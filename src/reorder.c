@@ -0,0 +1,286 @@
+/* Copyright (C) NHR@FAU, University Erlangen-Nuremberg.
+ * All rights reserved. This file is part of SparseBench.
+ * Use of this source code is governed by a MIT style
+ * license that can be found in the LICENSE file. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "allocate.h"
+#include "reorder.h"
+#include "util.h"
+
+static const char *ReorderNames[NUMREORDER] = { "none", "rcm" };
+
+ReorderStats ReordStats = { .valid = false };
+
+// Scratch space of the breadth first searches over the local rows
+typedef struct {
+  CG_UINT *degree; // number of local off-diagonal neighbors
+  CG_UINT *visited; // stamp of the last search that reached a row
+  CG_UINT stamp;
+  CG_UINT *queue;
+  unsigned char *numbered; // row is part of the ordering
+} Workspace;
+
+ReorderType reorderType(const char *name)
+{
+  for (int i = 0; i < NUMREORDER; i++) {
+    if (strcmp(name, ReorderNames[i]) == 0) {
+      return (ReorderType)i;
+    }
+  }
+
+  printf("Unknown reordering %s\n", name);
+  exit(EXIT_FAILURE);
+}
+
+const char *reorderName(ReorderType type)
+{
+  return ReorderNames[type];
+}
+
+// Halo columns are numbered behind the local rows and do not count
+static inline bool isNeighbor(GMatrix *m, CG_UINT row, CG_GINT col)
+{
+  return col < m->nr && col != row;
+}
+
+// Bandwidth and profile of the local blocks in the numbering given by newToOld
+// and oldToNew, the current numbering if both are NULL
+static void measureBandwidth(GMatrix *m,
+    const CG_UINT *newToOld,
+    const CG_UINT *oldToNew,
+    CG_GINT *bandwidth,
+    CG_GINT *profile)
+{
+  CG_GINT bw   = 0;
+  CG_GINT prof = 0;
+
+  for (CG_UINT i = 0; i < m->nr; i++) {
+    CG_UINT old   = newToOld != NULL ? newToOld[i] : i;
+    CG_GINT first = i;
+
+    for (CG_UINT j = m->rowPtr[old]; j < m->rowPtr[old + 1]; j++) {
+      CG_GINT col = m->entries[j].col;
+
+      if (col < m->nr) {
+        col   = oldToNew != NULL ? oldToNew[col] : col;
+        bw    = MAX(bw, col > i ? col - i : i - col);
+        first = MIN(first, col);
+      }
+    }
+    prof += i - first;
+  }
+
+#ifdef _MPI
+  MPI_Allreduce(MPI_IN_PLACE, &bw, 1, MPI_GINT_TYPE, MPI_MAX, MPI_COMM_WORLD);
+  MPI_Allreduce(MPI_IN_PLACE, &prof, 1, MPI_GINT_TYPE, MPI_SUM, MPI_COMM_WORLD);
+#endif
+  *bandwidth = bw;
+  *profile   = prof;
+}
+
+// Breadth first search from start, returns the row reached last. Repeated from
+// its result this walks towards a pseudo-peripheral row of the component.
+static CG_UINT lastReached(GMatrix *m, Workspace *w, CG_UINT start)
+{
+  CG_UINT head = 0, tail = 0;
+
+  w->stamp++;
+  w->visited[start] = w->stamp;
+  w->queue[tail++]  = start;
+
+  while (head < tail) {
+    CG_UINT v = w->queue[head++];
+
+    for (CG_UINT j = m->rowPtr[v]; j < m->rowPtr[v + 1]; j++) {
+      CG_GINT u = m->entries[j].col;
+
+      if (isNeighbor(m, v, u) && w->visited[u] != w->stamp) {
+        w->visited[u]    = w->stamp;
+        w->queue[tail++] = (CG_UINT)u;
+      }
+    }
+  }
+
+  return w->queue[tail - 1];
+}
+
+// Cuthill-McKee ordering of the component of root, appended to order at n.
+// The unnumbered neighbors of every row are appended by ascending degree.
+static CG_UINT cuthillMcKee(
+    GMatrix *m, Workspace *w, CG_UINT root, CG_UINT *order, CG_UINT n)
+{
+  CG_UINT head = n, tail = n;
+
+  w->numbered[root] = 1;
+  order[tail++]     = root;
+
+  while (head < tail) {
+    CG_UINT v     = order[head++];
+    CG_UINT first = tail;
+
+    for (CG_UINT j = m->rowPtr[v]; j < m->rowPtr[v + 1]; j++) {
+      CG_GINT u = m->entries[j].col;
+
+      if (isNeighbor(m, v, u) && !w->numbered[u]) {
+        w->numbered[u] = 1;
+        order[tail++]  = (CG_UINT)u;
+      }
+    }
+
+    // Rows have few neighbors, insertion sort is sufficient
+    for (CG_UINT k = first + 1; k < tail; k++) {
+      CG_UINT u = order[k];
+      CG_UINT l = k;
+
+      while (l > first && w->degree[order[l - 1]] > w->degree[u]) {
+        order[l] = order[l - 1];
+        l--;
+      }
+      order[l] = u;
+    }
+  }
+
+  return tail;
+}
+
+static int compareEntryCol(const void *a, const void *b)
+{
+  CG_GINT ca = ((const Entry *)a)->col;
+  CG_GINT cb = ((const Entry *)b)->col;
+
+  return (ca > cb) - (ca < cb);
+}
+
+// Moves the rows into the new order and renumbers the local columns. The entry
+// array keeps its size since the conversion may read up to m->nnz entries.
+static void permuteRows(GMatrix *m, const CG_UINT *newToOld, const CG_UINT *oldToNew)
+{
+  CG_UINT *rowPtr = (CG_UINT *)allocate(ARRAY_ALIGNMENT,
+      (m->nr + 1) * sizeof(CG_UINT));
+  Entry *entries  = (Entry *)allocate(ARRAY_ALIGNMENT, m->nnz * sizeof(Entry));
+
+  rowPtr[0] = 0;
+  for (CG_UINT i = 0; i < m->nr; i++) {
+    CG_UINT old = newToOld[i];
+    CG_UINT k   = rowPtr[i];
+
+    for (CG_UINT j = m->rowPtr[old]; j < m->rowPtr[old + 1]; j++) {
+      CG_GINT col = m->entries[j].col;
+
+      entries[k].col   = col < m->nr ? oldToNew[col] : col;
+      entries[k++].val = m->entries[j].val;
+    }
+
+    qsort(entries + rowPtr[i], k - rowPtr[i], sizeof(Entry), compareEntryCol);
+    rowPtr[i + 1] = k;
+  }
+
+  free(m->rowPtr);
+  free(m->entries);
+  m->rowPtr  = rowPtr;
+  m->entries = entries;
+}
+
+/**
+ * @brief Reduce the bandwidth of the rank local matrix block.
+ *
+ * With reordering rcm the local rows are renumbered by reverse Cuthill-McKee
+ * on the graph of the local block. Every connected component starts at a
+ * pseudo-peripheral row found by two breadth first searches. Halo columns stay
+ * behind the local rows, rows of other ranks are not moved, so the ownership
+ * of rows and the communication volume are unchanged. The exchange plan is
+ * updated to the new local indices. If the profile does not shrink, the
+ * original numbering is kept.
+ *
+ * Bandwidth and profile of the local blocks before and after are stored in
+ * ReordStats and printed on the master rank. This is a collective call.
+ *
+ * @param[in,out] c Communication structure with a completed localization
+ * @param p Parameters, p->reorder selects the ordering
+ * @param[in,out] m Localized matrix, reordered rows are sorted by column
+ */
+void reorderMatrix(CommType *c, Parameter *p, GMatrix *m)
+{
+  ReorderType type = reorderType(p->reorder);
+  CG_UINT nr       = m->nr;
+
+  m->newToOld = NULL;
+  if (type == REORDER_NONE) {
+    return;
+  }
+
+  measureBandwidth(m, NULL, NULL, &ReordStats.bandwidth[0], &ReordStats.profile[0]);
+
+  Workspace w;
+  w.degree   = (CG_UINT *)allocate(ARRAY_ALIGNMENT, MAX(nr, 1) * sizeof(CG_UINT));
+  w.visited  = (CG_UINT *)allocate(ARRAY_ALIGNMENT, MAX(nr, 1) * sizeof(CG_UINT));
+  w.queue    = (CG_UINT *)allocate(ARRAY_ALIGNMENT, MAX(nr, 1) * sizeof(CG_UINT));
+  w.numbered = (unsigned char *)allocate(ARRAY_ALIGNMENT, MAX(nr, 1));
+  w.stamp    = 0;
+  memset(w.visited, 0, nr * sizeof(CG_UINT));
+  memset(w.numbered, 0, nr);
+
+  for (CG_UINT i = 0; i < nr; i++) {
+    w.degree[i] = 0;
+    for (CG_UINT j = m->rowPtr[i]; j < m->rowPtr[i + 1]; j++) {
+      w.degree[i] += isNeighbor(m, i, m->entries[j].col);
+    }
+  }
+
+  CG_UINT *order = (CG_UINT *)allocate(ARRAY_ALIGNMENT, MAX(nr, 1) * sizeof(CG_UINT));
+  CG_UINT n      = 0;
+
+  for (CG_UINT i = 0; i < nr; i++) {
+    if (!w.numbered[i]) {
+      CG_UINT root = lastReached(m, &w, lastReached(m, &w, i));
+      n            = cuthillMcKee(m, &w, root, order, n);
+    }
+  }
+
+  CG_UINT *newToOld = (CG_UINT *)allocate(ARRAY_ALIGNMENT,
+      MAX(nr, 1) * sizeof(CG_UINT));
+  CG_UINT *oldToNew = w.visited;
+
+  for (CG_UINT i = 0; i < nr; i++) {
+    newToOld[i]           = order[nr - 1 - i];
+    oldToNew[newToOld[i]] = i;
+  }
+
+  measureBandwidth(m,
+      newToOld,
+      oldToNew,
+      &ReordStats.bandwidth[1],
+      &ReordStats.profile[1]);
+
+  if (commIsMaster(c)) {
+    printf("Reordering %s: bandwidth %lld -> %lld, profile %lld -> %lld\n",
+        reorderName(type),
+        ReordStats.bandwidth[0],
+        ReordStats.bandwidth[1],
+        ReordStats.profile[0],
+        ReordStats.profile[1]);
+  }
+
+  // Already banded orderings, e.g. of generated matrices, are kept. The profile
+  // is summed over all ranks, so all ranks take the same decision.
+  if (ReordStats.profile[1] < ReordStats.profile[0]) {
+    permuteRows(m, newToOld, oldToNew);
+    commRenumber(c, oldToNew);
+    m->newToOld      = newToOld;
+    ReordStats.valid = true;
+  } else {
+    if (commIsMaster(c)) {
+      printf("Reordering does not reduce the profile, keeping the original order\n");
+    }
+    free(newToOld);
+  }
+
+  free(w.degree);
+  free(w.visited);
+  free(w.queue);
+  free(w.numbered);
+  free(order);
+}
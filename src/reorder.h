@@ -0,0 +1,33 @@
+/* Copyright (C) NHR@FAU, University Erlangen-Nuremberg.
+ * All rights reserved. This file is part of SparseBench.
+ * Use of this source code is governed by a MIT style
+ * license that can be found in the LICENSE file. */
+#ifndef __REORDER_H_
+#define __REORDER_H_
+#include "comm.h"
+#include "matrix.h"
+#include "parameter.h"
+#include "util.h"
+
+typedef enum { REORDER_NONE = 0, REORDER_RCM, NUMREORDER } ReorderType;
+
+// Bandwidth (largest distance of a local column to the diagonal, maximum over
+// the ranks) and profile (summed distance of the first local column of every
+// row to the diagonal, sum over the ranks) before ([0]) and after ([1]) the
+// reordering of the rank local rows
+typedef struct {
+  bool valid;
+  CG_GINT bandwidth[2];
+  CG_GINT profile[2];
+} ReorderStats;
+
+extern ReorderStats ReordStats;
+
+extern ReorderType reorderType(const char *name);
+extern const char *reorderName(ReorderType type);
+// Renumbers the local rows of a localized matrix and the exchange plan. The
+// original local row of every row is kept in m->newToOld, which is NULL without
+// reordering.
+extern void reorderMatrix(CommType *c, Parameter *p, GMatrix *m);
+
+#endif // __REORDER_H_
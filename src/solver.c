@@ -10,9 +10,86 @@
 #include <string.h>
 
 #include "comm.h"
+#include "profiler.h"
 #include "solver.h"
+#include "timing.h"
 #include "util.h"
 
+int RegionWaxpby = NOREGION;
+int RegionSpMVM  = NOREGION;
+int RegionDdot   = NOREGION;
+int RegionComm   = NOREGION;
+
+/**
+ * @brief Register the profiler regions of the solver kernels.
+ *
+ * Collective call. The work models are per call and summed over all ranks:
+ * waxpby reads two and writes one vector, ddot reads one or two vectors and is
+ * modelled with the average of both variants, the spMVM traffic follows
+ * spMVMTraffic. The halo exchange and the reduction are nested into comm and
+ * ddot.
+ *
+ * @param c Communication structure after commLocalization
+ * @param m Converted matrix
+ * @param xReuse Assumed reuse of the input vector in the spMVM traffic model
+ */
+void solverRegisterRegions(CommType *c, Matrix *m, double xReuse)
+{
+  size_t n         = m->totalNr;
+  size_t spmvBytes = spMVMTraffic(m, xReuse);
+
+  commReduceSum(&spmvBytes);
+
+  RegionWaxpby = profilerRegister("waxpby", 2 * n, 3 * sizeof(CG_FLOAT) * n, NOREGION);
+  RegionSpMVM  = profilerRegister("spmv", 2 * m->totalNnz, spmvBytes, NOREGION);
+  RegionDdot   = profilerRegister("ddot", 2 * n, 3 * sizeof(CG_FLOAT) * n / 2, NOREGION);
+  RegionComm   = profilerRegister("comm", 0, commExchangeBytes(c), NOREGION);
+
+  commRegisterRegions(c, RegionComm, RegionDdot);
+  profilerSetCommRegion(RegionComm);
+}
+
+/**
+ * @brief Sparse matrix vector multiplication y = A x.
+ *
+ * Calls the kernel of the storage format directly instead of through the
+ * format table, so the call in the solver loop stays a direct call.
+ *
+ * @param m Matrix
+ * @param x Input vector including the halo elements
+ * @param y Output vector
+ */
+void spMVM(Matrix *m, const CG_FLOAT *restrict x, CG_FLOAT *restrict y)
+{
+  switch (m->format) {
+  case FMT_CRS:
+    spMVMCRS(m, x, y);
+    break;
+  case FMT_SCS:
+    spMVMSCS(m, x, y);
+    break;
+  case FMT_CCRS:
+    spMVMCCRS(m, x, y);
+    break;
+  case FMT_CRS16:
+    spMVMCRS16(m, x, y);
+    break;
+  case FMT_CRSF:
+    spMVMCRSF(m, x, y);
+    break;
+  case FMT_STENCIL:
+    spMVMSTENCIL(m, x, y);
+    break;
+  case FMT_SYM:
+    spMVMSYM(m, x, y);
+    break;
+  case FMT_BCSR:
+    spMVMBCSR(m, x, y);
+    break;
+  default:;
+  }
+}
+
 void waxpby(const CG_UINT n,
     const CG_FLOAT alpha,
     const CG_FLOAT *restrict x,
@@ -20,21 +97,31 @@ void waxpby(const CG_UINT n,
     const CG_FLOAT *restrict y,
     CG_FLOAT *const w)
 {
-  if (alpha == 1.0) {
-#pragma omp parallel for schedule(static)
-    for (int i = 0; i < n; i++) {
-      w[i] = x[i] + beta * y[i];
-    }
-  } else if (beta == 1.0) {
-#pragma omp parallel for schedule(static)
-    for (int i = 0; i < n; i++) {
-      w[i] = alpha * x[i] + y[i];
-    }
-  } else {
-#pragma omp parallel for schedule(static)
-    for (int i = 0; i < n; i++) {
-      w[i] = alpha * x[i] + beta * y[i];
+#pragma omp parallel
+  {
+    THREAD_TIMER_START;
+
+    if (alpha == 1.0) {
+#pragma omp for schedule(static) nowait
+      for (int i = 0; i < n; i++) {
+        w[i] = x[i] + beta * y[i];
+        THREAD_TIMER_WORK(1);
+      }
+    } else if (beta == 1.0) {
+#pragma omp for schedule(static) nowait
+      for (int i = 0; i < n; i++) {
+        w[i] = alpha * x[i] + y[i];
+        THREAD_TIMER_WORK(1);
+      }
+    } else {
+#pragma omp for schedule(static) nowait
+      for (int i = 0; i < n; i++) {
+        w[i] = alpha * x[i] + beta * y[i];
+        THREAD_TIMER_WORK(1);
+      }
     }
+
+    THREAD_TIMER_STOP(RegionWaxpby);
   }
 }
 
@@ -45,16 +132,25 @@ void ddot(const CG_UINT n,
 {
   CG_FLOAT sum = 0.0;
 
-  if (y == x) {
-#pragma omp parallel for reduction(+ : sum) schedule(static)
-    for (int i = 0; i < n; i++) {
-      sum += x[i] * x[i];
-    }
-  } else {
-#pragma omp parallel for reduction(+ : sum) schedule(static)
-    for (int i = 0; i < n; i++) {
-      sum += x[i] * y[i];
+#pragma omp parallel
+  {
+    THREAD_TIMER_START;
+
+    if (y == x) {
+#pragma omp for reduction(+ : sum) schedule(static) nowait
+      for (int i = 0; i < n; i++) {
+        sum += x[i] * x[i];
+        THREAD_TIMER_WORK(1);
+      }
+    } else {
+#pragma omp for reduction(+ : sum) schedule(static) nowait
+      for (int i = 0; i < n; i++) {
+        sum += x[i] * y[i];
+        THREAD_TIMER_WORK(1);
+      }
     }
+
+    THREAD_TIMER_STOP(RegionDdot);
   }
 
   commReduction(&sum, SUM);
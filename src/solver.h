@@ -8,9 +8,21 @@
 #include "parameter.h"
 #include "util.h"
 
+// Profiler regions of the solver kernels
+extern int RegionWaxpby, RegionSpMVM, RegionDdot, RegionComm;
+
+extern void solverRegisterRegions(CommType *c, Matrix *m, double xReuse);
 extern int solveCG(CommType *comm, Parameter *param, Matrix *m);
 // extern void solverCheckResidual(Solver* s, Comm* c);
 extern void spMVM(Matrix *m, const CG_FLOAT *restrict x, CG_FLOAT *restrict y);
+extern void spMVMCRS(Matrix *m, const CG_FLOAT *restrict x, CG_FLOAT *restrict y);
+extern void spMVMSCS(Matrix *m, const CG_FLOAT *restrict x, CG_FLOAT *restrict y);
+extern void spMVMCCRS(Matrix *m, const CG_FLOAT *restrict x, CG_FLOAT *restrict y);
+extern void spMVMCRS16(Matrix *m, const CG_FLOAT *restrict x, CG_FLOAT *restrict y);
+extern void spMVMCRSF(Matrix *m, const CG_FLOAT *restrict x, CG_FLOAT *restrict y);
+extern void spMVMSTENCIL(Matrix *m, const CG_FLOAT *restrict x, CG_FLOAT *restrict y);
+extern void spMVMSYM(Matrix *m, const CG_FLOAT *restrict x, CG_FLOAT *restrict y);
+extern void spMVMBCSR(Matrix *m, const CG_FLOAT *restrict x, CG_FLOAT *restrict y);
 
 extern void waxpby(const CG_UINT n,
     const CG_FLOAT alpha,
@@ -0,0 +1,129 @@
+/* Copyright (C) NHR@FAU, University Erlangen-Nuremberg.
+ * All rights reserved. This file is part of SparseBench.
+ * Use of this source code is governed by a MIT style
+ * license that can be found in the LICENSE file. */
+#include <float.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "allocate.h"
+#include "comm.h"
+#include "stream.h"
+#include "timing.h"
+#include "util.h"
+
+#define NTIMES 10
+
+typedef struct {
+  char *label;
+  size_t words; // vector elements transferred per loop iteration
+} StreamKernel;
+
+static StreamKernel Kernels[NUMSTREAM] = {
+  { "copy:     ", 2 },
+  { "triad:    ", 3 },
+  { "load:     ", 1 }
+};
+
+// Keeps the compiler from removing the load kernel
+static volatile CG_FLOAT Sink;
+
+static double runKernel(StreamKernelType kernel,
+    CG_UINT n,
+    CG_FLOAT *restrict a,
+    CG_FLOAT *restrict b,
+    CG_FLOAT *restrict c)
+{
+  const CG_FLOAT scalar = 3.0;
+  CG_FLOAT sum          = 0.0;
+
+  commBarrier();
+  double ts = getTimeStamp();
+
+  switch (kernel) {
+  case STREAM_COPY:
+#pragma omp parallel for schedule(static)
+    for (int i = 0; i < n; i++) {
+      c[i] = a[i];
+    }
+    break;
+  case STREAM_TRIAD:
+#pragma omp parallel for schedule(static)
+    for (int i = 0; i < n; i++) {
+      a[i] = b[i] + scalar * c[i];
+    }
+    break;
+  case STREAM_LOAD:
+#pragma omp parallel for reduction(+ : sum) schedule(static)
+    for (int i = 0; i < n; i++) {
+      sum += a[i];
+    }
+    Sink += sum;
+    break;
+  default:;
+  }
+
+  double time = getTimeStamp() - ts;
+#ifdef _MPI
+  MPI_Allreduce(MPI_IN_PLACE, &time, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+#endif
+  return time;
+}
+
+/**
+ * @brief Measure the attainable memory bandwidth with STREAM like kernels.
+ *
+ * Runs copy (c = a), triad (a = b + s * c) and a load only reduction
+ * (sum += a) NTIMES each on all ranks simultaneously and keeps the best time.
+ * The arrays are allocated with allocate and initialized in parallel for first
+ * touch placement like the solver vectors. Write allocate transfers are not
+ * counted, as in STREAM.
+ *
+ * @param c Communication structure
+ * @param megabytes Total size of the three arrays per rank
+ * @param[out] bandwidth Aggregated bandwidth of all ranks in GB/s per kernel
+ */
+void streamCalibrate(CommType *c, size_t megabytes, double *bandwidth)
+{
+  CG_UINT n   = (CG_UINT)(megabytes * 1000 * 1000 / (3 * sizeof(CG_FLOAT)));
+  CG_FLOAT *a = (CG_FLOAT *)allocate(ARRAY_ALIGNMENT, n * sizeof(CG_FLOAT));
+  CG_FLOAT *b = (CG_FLOAT *)allocate(ARRAY_ALIGNMENT, n * sizeof(CG_FLOAT));
+  CG_FLOAT *d = (CG_FLOAT *)allocate(ARRAY_ALIGNMENT, n * sizeof(CG_FLOAT));
+
+#pragma omp parallel for schedule(static)
+  for (int i = 0; i < n; i++) {
+    a[i] = 1.0;
+    b[i] = 2.0;
+    d[i] = 0.0;
+  }
+
+  double tmin[NUMSTREAM];
+
+  for (int k = 0; k < NUMSTREAM; k++) {
+    tmin[k] = DBL_MAX;
+  }
+
+  for (int iter = 0; iter < NTIMES; iter++) {
+    for (int k = 0; k < NUMSTREAM; k++) {
+      double time = runKernel((StreamKernelType)k, n, a, b, d);
+      tmin[k]     = MIN(tmin[k], time);
+    }
+  }
+
+  if (commIsMaster(c)) {
+    printf("Memory bandwidth calibration with %zu MB per rank\n", megabytes);
+  }
+
+  for (int k = 0; k < NUMSTREAM; k++) {
+    double bytes = (double)Kernels[k].words * sizeof(CG_FLOAT) * n * c->size;
+    bandwidth[k] = 1.0E-09 * bytes / tmin[k];
+
+    if (commIsMaster(c)) {
+      printf("%s%11.2f GB/s\n", Kernels[k].label, bandwidth[k]);
+    }
+  }
+
+  free(d);
+  free(b);
+  free(a);
+}
@@ -0,0 +1,19 @@
+/* Copyright (C) NHR@FAU, University Erlangen-Nuremberg.
+ * All rights reserved. This file is part of SparseBench.
+ * Use of this source code is governed by a MIT style
+ * license that can be found in the LICENSE file. */
+#ifndef __STREAM_H_
+#define __STREAM_H_
+#include <stddef.h>
+
+#include "comm.h"
+
+typedef enum { STREAM_COPY = 0, STREAM_TRIAD, STREAM_LOAD, NUMSTREAM } StreamKernelType;
+
+// STREAM like memory bandwidth calibration. Every rank runs the kernels on
+// arrays with a total size of megabytes at the same time, using the OpenMP
+// schedule and allocation of the solver kernels. bandwidth receives the
+// aggregated bandwidth of all ranks in GB/s on every rank.
+extern void streamCalibrate(CommType *c, size_t megabytes, double *bandwidth);
+
+#endif // __STREAM_H_
@@ -0,0 +1,235 @@
+/* Copyright (C) NHR@FAU, University Erlangen-Nuremberg.
+ * All rights reserved. This file is part of SparseBench.
+ * Use of this source code is governed by a MIT style
+ * license that can be found in the LICENSE file. */
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "allocate.h"
+#include "comm.h"
+#include "timing.h"
+#include "trace.h"
+#include "util.h"
+
+#define TRACE_INITIAL 4096
+
+typedef struct {
+  double start, stop; // seconds since the trace origin
+  int event;
+  int thread;
+} TraceRecord;
+
+// Events of one thread, every thread only appends to its own buffer
+typedef struct {
+  size_t count, capacity;
+  TraceRecord *records;
+} TraceBuffer;
+
+static bool Enabled         = false;
+static double Origin        = 0.0;
+static int NumThreads       = 1;
+static TraceBuffer *Buffers = NULL;
+static size_t Written       = 0; // events in the output file
+
+static int threadId(void)
+{
+#ifdef _OPENMP
+  return omp_get_thread_num();
+#else
+  return 0;
+#endif
+}
+
+/**
+ * @brief Start recording events.
+ *
+ * Collective call. The ranks take their time origin after a barrier, which
+ * aligns the timelines of all ranks up to the skew of leaving the barrier.
+ *
+ * @param c Communication structure
+ */
+void traceInit(CommType *c)
+{
+#ifdef _OPENMP
+  NumThreads = omp_get_max_threads();
+#endif
+  Buffers = (TraceBuffer *)allocate(ARRAY_ALIGNMENT, NumThreads * sizeof(TraceBuffer));
+  memset(Buffers, 0, NumThreads * sizeof(TraceBuffer));
+
+  commBarrier();
+  Origin  = getTimeStamp();
+  Enabled = true;
+}
+
+bool traceEnabled(void)
+{
+  return Enabled;
+}
+
+void traceEvent(int event, double start, double stop)
+{
+  if (!Enabled) {
+    return;
+  }
+
+  int thread          = threadId();
+  TraceBuffer *buffer = &Buffers[thread];
+
+  if (buffer->count == buffer->capacity) {
+    buffer->capacity = buffer->capacity ? 2 * buffer->capacity : TRACE_INITIAL;
+    buffer->records  = (TraceRecord *)realloc(
+        buffer->records, buffer->capacity * sizeof(TraceRecord));
+    if (buffer->records == NULL) {
+      printf("Could not allocate trace events\n");
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  buffer->records[buffer->count++] = (TraceRecord) {
+    start - Origin, stop - Origin, event, thread
+  };
+}
+
+// Events of all threads of this rank in one array
+static TraceRecord *collectRecords(size_t *count)
+{
+  size_t n = 0;
+
+  for (int t = 0; t < NumThreads; t++) {
+    n += Buffers[t].count;
+  }
+
+  TraceRecord *records = (TraceRecord *)malloc(MAX(n, 1) * sizeof(TraceRecord));
+  size_t offset        = 0;
+
+  for (int t = 0; t < NumThreads; t++) {
+    memcpy(records + offset, Buffers[t].records, Buffers[t].count * sizeof(TraceRecord));
+    offset += Buffers[t].count;
+  }
+
+  *count = n;
+  return records;
+}
+
+// JSON array elements are separated by commas
+static void beginEvent(FILE *fp)
+{
+  fputs(Written++ > 0 ? ",\n" : "\n", fp);
+}
+
+static void writeRecords(
+    FILE *fp, int rank, TraceRecord *records, size_t count, const char **names)
+{
+  for (size_t i = 0; i < count; i++) {
+    beginEvent(fp);
+    FPRINTF(fp,
+        "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":%d,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+        names[records[i].event],
+        rank,
+        records[i].thread,
+        1.0E06 * records[i].start,
+        1.0E06 * (records[i].stop - records[i].start));
+  }
+}
+
+static void writeMetadata(FILE *fp, int rank, int threads)
+{
+  beginEvent(fp);
+  FPRINTF(fp,
+      "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,"
+      "\"args\":{\"name\":\"rank %d\"}}",
+      rank,
+      rank);
+  for (int t = 0; t < threads; t++) {
+    beginEvent(fp);
+    FPRINTF(fp,
+        "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,"
+        "\"args\":{\"name\":\"thread %d\"}}",
+        rank,
+        t,
+        t);
+  }
+}
+
+/**
+ * @brief Write the recorded events of all ranks as Chrome trace JSON.
+ *
+ * Collective call. The ranks send their events one after the other to the
+ * master, which writes them to the file. Every rank is a process and every
+ * OpenMP thread a thread in the timeline, times are in microseconds.
+ *
+ * @param c Communication structure
+ * @param filename Output file name
+ * @param names Event names indexed by the event id
+ */
+void traceWrite(CommType *c, char *filename, const char **names)
+{
+  size_t count;
+  TraceRecord *records = collectRecords(&count);
+
+  if (!commIsMaster(c)) {
+#ifdef _MPI
+    unsigned long long n = count;
+    MPI_Send(&n, 1, MPI_UNSIGNED_LONG_LONG, 0, 0, MPI_COMM_WORLD);
+    MPI_Send(&NumThreads, 1, MPI_INT, 0, 0, MPI_COMM_WORLD);
+    commSendLarge(records, count * sizeof(TraceRecord), MPI_BYTE, 0, 0);
+#endif
+    free(records);
+    return;
+  }
+
+  FILE *fp = fopen(filename, "w");
+  if (fp == NULL) {
+    printf("Warning: Could not open trace file %s\n", filename);
+  } else {
+    Written = 0;
+    FPRINTF(fp, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    writeMetadata(fp, 0, NumThreads);
+    writeRecords(fp, 0, records, count, names);
+  }
+  free(records);
+  size_t total = count;
+
+#ifdef _MPI
+  for (int rank = 1; rank < c->size; rank++) {
+    unsigned long long n;
+    int threads;
+
+    MPI_Recv(&n, 1, MPI_UNSIGNED_LONG_LONG, rank, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+    MPI_Recv(&threads, 1, MPI_INT, rank, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+    records = (TraceRecord *)malloc(MAX(n, 1) * sizeof(TraceRecord));
+    commRecvLarge(records, n * sizeof(TraceRecord), MPI_BYTE, rank, 0);
+
+    if (fp != NULL) {
+      writeMetadata(fp, rank, threads);
+      writeRecords(fp, rank, records, n, names);
+    }
+    free(records);
+    total += n;
+  }
+#endif
+
+  if (fp != NULL) {
+    FPRINTF(fp, "\n]}\n");
+    FCLOSE(fp);
+    printf("Wrote %zu trace events to %s\n", total, filename);
+  }
+}
+
+void traceFinalize(void)
+{
+  if (Buffers != NULL) {
+    for (int t = 0; t < NumThreads; t++) {
+      free(Buffers[t].records);
+    }
+    free(Buffers);
+  }
+  Buffers = NULL;
+  Enabled = false;
+}
@@ -0,0 +1,21 @@
+/* Copyright (C) NHR@FAU, University Erlangen-Nuremberg.
+ * All rights reserved. This file is part of SparseBench.
+ * Use of this source code is governed by a MIT style
+ * license that can be found in the LICENSE file. */
+#ifndef __TRACE_H_
+#define __TRACE_H_
+#include <stdbool.h>
+
+#include "comm.h"
+
+// Timeline of timestamped events per rank and thread, written in the Chrome
+// trace event format that Perfetto and chrome://tracing load. Event ids are
+// the profiler region ids.
+
+extern void traceInit(CommType *c);
+extern bool traceEnabled(void);
+extern void traceEvent(int event, double start, double stop);
+extern void traceWrite(CommType *c, char *filename, const char **names);
+extern void traceFinalize(void);
+
+#endif // __TRACE_H_
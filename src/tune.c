@@ -0,0 +1,373 @@
+/* Copyright (C) NHR@FAU, University Erlangen-Nuremberg.
+ * All rights reserved. This file is part of SparseBench.
+ * Use of this source code is governed by a MIT style
+ * license that can be found in the LICENSE file. */
+#include <float.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "allocate.h"
+#include "comm.h"
+#include "matrix.h"
+#include "reorder.h"
+#include "solver.h"
+#include "stream.h"
+#include "timing.h"
+#include "tune.h"
+#include "util.h"
+
+#define STRINGIFY(x) #x
+#define TOSTRING(x) STRINGIFY(x)
+
+typedef struct {
+  FormatType format;
+  int C, sigma;
+} Candidate;
+
+typedef struct {
+  const char *name;
+#ifdef _OPENMP
+  omp_sched_t kind;
+  int chunk;
+#endif
+} Schedule;
+
+// SCS chunk heights and sorting scopes in multiples of the chunk height
+static const int ChunkHeights[]  = { 4, 8, 16, 32 };
+static const int SortingScopes[] = { 1, 32, 256 };
+
+#ifdef _OPENMP
+static const Schedule Schedules[] = {
+  { "static",     omp_sched_static,  0  },
+  { "dynamic,64", omp_sched_dynamic, 64 },
+  { "guided",     omp_sched_guided,  0  }
+};
+#endif
+
+#define NUMCHUNKHEIGHTS (int)(sizeof(ChunkHeights) / sizeof(ChunkHeights[0]))
+#define NUMSORTINGSCOPES (int)(sizeof(SortingScopes) / sizeof(SortingScopes[0]))
+#define MAXCANDIDATES (7 + NUMCHUNKHEIGHTS * NUMSORTINGSCOPES)
+
+static double reduceMax(double value)
+{
+#ifdef _MPI
+  MPI_Allreduce(MPI_IN_PLACE, &value, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+#endif
+  return value;
+}
+
+static double reduceSum(double value)
+{
+#ifdef _MPI
+  MPI_Allreduce(MPI_IN_PLACE, &value, 1, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+#endif
+  return value;
+}
+
+// The matrix free stencil is only a candidate for generated matrices, SYM only
+// for symmetric local blocks on all ranks and the lossy CRSF only on request
+static int buildCandidates(Candidate *candidates, Parameter *p, GMatrix *m)
+{
+  StencilMatrix stencil;
+  int n             = 0;
+
+  candidates[n++]   = (Candidate) { FMT_CRS, 1, 1 };
+  candidates[n++]   = (Candidate) { FMT_CCRS, 1, 1 };
+  candidates[n++]   = (Candidate) { FMT_CRS16, 1, 1 };
+  candidates[n++]   = (Candidate) { FMT_BCSR, 1, 1 };
+  if (p->lossy) {
+    candidates[n++] = (Candidate) { FMT_CRSF, 1, 1 };
+  }
+  for (int i = 0; i < NUMCHUNKHEIGHTS; i++) {
+    for (int j = 0; j < NUMSORTINGSCOPES; j++) {
+      int C           = ChunkHeights[i];
+      int sigma       = SortingScopes[j] == 1 ? 1 : SortingScopes[j] * C;
+      candidates[n++] = (Candidate) { FMT_SCS, C, sigma };
+    }
+  }
+  if (reduceMax(!matrixLocalSymmetric(m)) == 0.0) {
+    candidates[n++] = (Candidate) { FMT_SYM, 1, 1 };
+  }
+  // The stencil kernel generates the rows in the original numbering
+  if (reorderType(p->reorder) == REORDER_NONE && stencilInit(&stencil, p)) {
+    candidates[n++] = (Candidate) { FMT_STENCIL, 1, 1 };
+  }
+
+  return n;
+}
+
+// SCS with sigma > 1 writes y in the sorted row order and is no operator for CG,
+// it is timed for comparison but never recommended
+static bool solverCapable(Candidate *cand)
+{
+  return cand->format != FMT_SCS || cand->sigma == 1;
+}
+
+static const char *candidateNote(Candidate *cand)
+{
+  if (!solverCapable(cand)) {
+    return " spMVM only";
+  } else if (cand->format == FMT_CRSF) {
+    return " lossy";
+  }
+
+  return "";
+}
+
+// The schedule only changes the kernels if they use schedule(runtime)
+static int buildSchedules(const Schedule **schedules)
+{
+  static const Schedule compiled = { .name = TOSTRING(OMP_SCHEDULE) };
+
+#ifdef _OPENMP
+  if (strcmp(TOSTRING(OMP_SCHEDULE), "runtime") == 0) {
+    *schedules = Schedules;
+    return (int)(sizeof(Schedules) / sizeof(Schedules[0]));
+  }
+#endif
+  *schedules = &compiled;
+  return 1;
+}
+
+// The generator reserves 27 entries per row in nnz, the copy only holds the
+// stored ones so that all formats model the same non zeros
+static void copyGMatrix(GMatrix *dst, GMatrix *src)
+{
+  *dst         = *src;
+  dst->nnz     = src->rowPtr[src->nr];
+  dst->rowPtr  = (CG_UINT *)allocate(ARRAY_ALIGNMENT, (src->nr + 1) * sizeof(CG_UINT));
+  dst->entries = (Entry *)allocate(ARRAY_ALIGNMENT, dst->nnz * sizeof(Entry));
+  memcpy(dst->rowPtr, src->rowPtr, (src->nr + 1) * sizeof(CG_UINT));
+  memcpy(dst->entries, src->entries, dst->nnz * sizeof(Entry));
+  dst->newToOld = NULL;
+}
+
+// Row length statistics of the localized matrix over all ranks
+static void printAnalysis(CommType *c, GMatrix *m)
+{
+  double minLen = DBL_MAX, maxLen = 0.0, sum = 0.0, sumSq = 0.0;
+
+  for (CG_UINT i = 0; i < m->nr; i++) {
+    double len = (double)(m->rowPtr[i + 1] - m->rowPtr[i]);
+
+    minLen     = MIN(minLen, len);
+    maxLen     = MAX(maxLen, len);
+    sum += len;
+    sumSq += len * len;
+  }
+
+  minLen       = -reduceMax(-minLen);
+  maxLen       = reduceMax(maxLen);
+  sum          = reduceSum(sum);
+  sumSq        = reduceSum(sumSq);
+
+  double avg   = sum / m->totalNr;
+  double sigma = sqrt(MAX(sumSq / m->totalNr - avg * avg, 0.0));
+
+  if (commIsMaster(c)) {
+    printf("Matrix analysis: %lld rows, %.0f non zeros\n", m->totalNr, sum);
+    printf("Non zeros per row: min %.0f avg %.2f max %.0f stddev %.2f\n",
+        minLen,
+        avg,
+        maxLen,
+        sigma);
+  }
+}
+
+// Slowest rank time of calls spMVMs after the warmup calls
+static double runTrial(Matrix *m, int warmup, int calls, CG_FLOAT *x, CG_FLOAT *y)
+{
+  for (int i = 0; i < warmup; i++) {
+    spMVM(m, x, y);
+  }
+
+  commBarrier();
+  double ts = getTimeStamp();
+  for (int i = 0; i < calls; i++) {
+    spMVM(m, x, y);
+  }
+
+  return reduceMax(getTimeStamp() - ts);
+}
+
+static void writeParameterFile(
+    Parameter *p, char *filename, Candidate *best, const char *schedule)
+{
+  FILE *fp = fopen(filename, "w");
+
+  if (fp == NULL) {
+    printf("Warning: Could not open parameter file %s\n", filename);
+    return;
+  }
+
+  // String values need a trailing space for readParameter
+  FPRINTF(fp, "# Tuned with sparseBench -t tune\n");
+  FPRINTF(fp, "filename %s \n", p->filename);
+  FPRINTF(fp, "nx %d\nny %d\nnz %d\n", p->nx, p->ny, p->nz);
+  FPRINTF(fp, "distribution %s \n", p->distribution);
+  FPRINTF(fp, "reorder %s \n", p->reorder);
+  if (best->format == FMT_CRSF) {
+    FPRINTF(fp, "# CRSF is lossy, it stores the matrix values in single precision\n");
+  }
+  FPRINTF(fp, "format %s \n", matrixFormatName(best->format));
+  FPRINTF(fp, "C %d\nsigma %d\n", best->C, best->sigma);
+  if (strcmp(schedule, TOSTRING(OMP_SCHEDULE)) != 0) {
+    FPRINTF(fp, "# export OMP_SCHEDULE=%s\n", schedule);
+  }
+  FCLOSE(fp);
+
+  printf("Wrote tuned parameters to %s\n", filename);
+}
+
+/**
+ * @brief Find the fastest matrix format for the localized matrix.
+ *
+ * Collective call. Every candidate converts a copy of m and runs p->warmup
+ * untimed and p->itermax timed spMVM calls on all ranks, the rate uses the
+ * slowest rank. The predicted rate follows the spMVM traffic model with the
+ * bandwidth given with -b, or measured with -s or TUNE_STREAM MB per rank.
+ * OpenMP schedules are only tried if the kernels are built with
+ * OMP_SCHEDULE=runtime. The winner is stored in p and, if p->tunefile is set,
+ * written to a parameter file.
+ *
+ * @param c Communication structure after commLocalization
+ * @param p Parameters, format, C and sigma are replaced by the winner
+ * @param m Localized matrix, left unchanged
+ */
+void tuneFormat(CommType *c, Parameter *p, GMatrix *m)
+{
+  Candidate candidates[MAXCANDIDATES];
+  const Schedule *schedules;
+  int numCandidates = buildCandidates(candidates, p, m);
+  int numSchedules  = buildSchedules(&schedules);
+  double bandwidth  = p->membw;
+
+  printAnalysis(c, m);
+
+  if (bandwidth <= 0.0) {
+    double stream[NUMSTREAM];
+
+    streamCalibrate(c, p->stream > 0 ? p->stream : TUNE_STREAM, stream);
+    bandwidth = stream[STREAM_LOAD];
+  }
+
+  CG_FLOAT *x = (CG_FLOAT *)allocate(ARRAY_ALIGNMENT, MAX(m->nc, 1) * sizeof(CG_FLOAT));
+  CG_FLOAT *y = (CG_FLOAT *)allocate(ARRAY_ALIGNMENT, MAX(m->nr, 1) * sizeof(CG_FLOAT));
+
+  for (CG_UINT i = 0; i < m->nc; i++) {
+    x[i] = (CG_FLOAT)1.0;
+  }
+
+  if (commIsMaster(c)) {
+    printf(HLINE);
+    printf("Tuning %d candidates with %d timed spMVM calls each\n",
+        numCandidates * numSchedules,
+        p->itermax);
+    printf("%-7s %4s %6s %-11s %6s %7s %13s %13s note\n",
+        "format",
+        "C",
+        "sigma",
+        "schedule",
+        "beta",
+        "B/Flop",
+        "pred MFlop/s",
+        "meas MFlop/s");
+  }
+
+  size_t nnz = m->rowPtr[m->nr];
+  commReduceSum(&nnz);
+
+  Candidate best     = candidates[0];
+  int bestSchedule   = 0;
+  double bestRate    = 0.0;
+  double bestPredict = 0.0;
+  double flops       = 2.0 * nnz;
+
+  for (int i = 0; i < numCandidates; i++) {
+    Candidate *cand = &candidates[i];
+    GMatrix im;
+    Matrix sm;
+
+    copyGMatrix(&im, m);
+    sm.format = cand->format;
+    if (cand->format == FMT_SCS) {
+      sm.scs.C     = (CG_UINT)cand->C;
+      sm.scs.sigma = (CG_UINT)cand->sigma;
+    } else if (cand->format == FMT_STENCIL) {
+      stencilInit(&sm.stencil, p);
+    }
+    convertMatrix(&sm, &im);
+
+    size_t traffic = spMVMTraffic(&sm, p->xreuse);
+    size_t elems   = nnz;
+    commReduceSum(&traffic);
+    if (cand->format == FMT_SCS) {
+      elems = sm.scs.nElems;
+      commReduceSum(&elems);
+    } else if (cand->format == FMT_BCSR) {
+      elems = (size_t)sm.bcsr.nBlocks * sm.bcsr.b * sm.bcsr.b;
+      commReduceSum(&elems);
+    }
+    double predict = 1.0E-06 * flops * bandwidth * 1.0E09 / traffic;
+
+    for (int s = 0; s < numSchedules; s++) {
+#ifdef _OPENMP
+      if (numSchedules > 1) {
+        omp_set_schedule(schedules[s].kind, schedules[s].chunk);
+      }
+#endif
+      double time = runTrial(&sm, p->warmup, p->itermax, x, y);
+      double rate = 1.0E-06 * flops * p->itermax / time;
+
+      if (commIsMaster(c)) {
+        printf("%-7s %4d %6d %-11s %6.3f %7.2f %13.2f %13.2f%s\n",
+            matrixFormatName(cand->format),
+            cand->C,
+            cand->sigma,
+            schedules[s].name,
+            (double)nnz / elems,
+            traffic / flops,
+            predict,
+            rate,
+            candidateNote(cand));
+      }
+      if (solverCapable(cand) && rate > bestRate) {
+        best         = *cand;
+        bestSchedule = s;
+        bestRate     = rate;
+        bestPredict  = predict;
+      }
+    }
+
+    matrixFree(&sm);
+  }
+
+  free(x);
+  free(y);
+
+  p->format = (char *)matrixFormatName(best.format);
+  p->C      = best.C;
+  p->sigma  = best.sigma;
+
+  if (commIsMaster(c)) {
+    printf(HLINE);
+    printf("Best: %s C=%d sigma=%d schedule %s, %.2f MFlop/s measured, %.2f "
+           "predicted\n",
+        p->format,
+        p->C,
+        p->sigma,
+        schedules[bestSchedule].name,
+        bestRate,
+        bestPredict);
+    if (p->tunefile != NULL) {
+      writeParameterFile(p, p->tunefile, &best, schedules[bestSchedule].name);
+    }
+  }
+}
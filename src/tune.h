@@ -0,0 +1,20 @@
+/* Copyright (C) NHR@FAU, University Erlangen-Nuremberg.
+ * All rights reserved. This file is part of SparseBench.
+ * Use of this source code is governed by a MIT style
+ * license that can be found in the LICENSE file. */
+#ifndef __TUNE_H_
+#define __TUNE_H_
+#include "comm.h"
+#include "matrix.h"
+#include "parameter.h"
+
+// Array size in MB per rank for the bandwidth calibration of the predicted rates
+// if neither -b nor -s is given
+#define TUNE_STREAM 256
+
+// Short timed spMVM trials over candidate formats, SCS chunk heights and sorting
+// scopes and, with OMP_SCHEDULE=runtime, OpenMP schedules. The winner is stored
+// in p->format, p->C and p->sigma.
+extern void tuneFormat(CommType *c, Parameter *p, GMatrix *m);
+
+#endif // __TUNE_H_
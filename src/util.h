@@ -43,6 +43,11 @@
 #define MPI_INT_TYPE MPI_UNSIGNED_LONG_LONG
 #define UINT_STRING "unsigned long long int"
 #endif
+#define CG_UINT_MAX ((CG_UINT)-1)
+
+// Global row and column indices are always 64 bit, rank local indices use CG_UINT
+#define CG_GINT long long int
+#define MPI_GINT_TYPE MPI_LONG_LONG_INT
 
 #if PRECISION == 1
 #define CG_FLOAT float
@@ -66,6 +71,17 @@ extern char *changeFileEnding(char *filename, char *newEnding);
     printf("%s:%d Error flushing file\n", __FILE__, __LINE__);                           \
   }
 
+#define FWRITE(ptr, size, count, stream)                                                 \
+  if (fwrite((ptr), (size), (count), (stream)) != (size_t)(count)) {                     \
+    printf("%s:%d Error writing to file\n", __FILE__, __LINE__);                         \
+  }
+
+#define FREAD(ptr, size, count, stream)                                                  \
+  if (fread((ptr), (size), (count), (stream)) != (size_t)(count)) {                      \
+    printf("%s:%d Error reading from file\n", __FILE__, __LINE__);                       \
+    exit(EXIT_FAILURE);                                                                  \
+  }
+
 #define FCLOSE(stream)                                                                   \
   if (fclose(stream) != 0) {                                                             \
     printf("%s:%d Error closing file\n", __FILE__, __LINE__);                            \
@@ -39,8 +39,8 @@ int sigma;
 #ifndef FORMAT_AND_STRIP_MATRIX_FILE
 #define FORMAT_AND_STRIP_MATRIX_FILE(A, entry, C_str, sigma_str)	\
 {                                                     				\
-	sprintf((C_str), "%d", (A).C);                      			\
-	sprintf((sigma_str), "%d", (A).sigma);              			\
+	sprintf((C_str), "%d", (A).scs.C);                      			\
+	sprintf((sigma_str), "%d", (A).scs.sigma);              			\
 	char *dot = strrchr((entry)->d_name, '.');          			\
 	if (dot != NULL) {                                  			\
 		*dot = '\0';                                      			\
@@ -0,0 +1,36 @@
+// Single rank test that the SYM format rejects a non-symmetric matrix whose
+// local block has as many entries below as above the diagonal
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../../src/matrix.h"
+#include "../common.h"
+
+int test_checkSYM(void* args, const char* dataDir){
+
+	char *pathToMatrix = malloc(strlen(dataDir) + strlen("testMatrices/test0.mtx") + 1);
+	strcpy(pathToMatrix, dataDir);
+	strcat(pathToMatrix, "testMatrices/test0.mtx");
+
+	MMMatrix mm;
+	MMMatrixRead(&mm, pathToMatrix);
+
+	// Set single rank defaults for MMMatrix
+	mm.startRow = 0;
+	mm.stopRow = mm.nr - 1;
+	mm.totalNr = mm.nr;
+	mm.totalNnz = mm.nnz;
+
+	GMatrix m;
+	matrixConvertfromMM(&mm, &m);
+
+	// test0 is not symmetric, SYM must not accept it
+	int failed = matrixLocalSymmetric(&m);
+
+	free(m.rowPtr);
+	free(m.entries);
+	free(pathToMatrix);
+
+	return failed;
+}
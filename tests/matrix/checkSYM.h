@@ -0,0 +1,6 @@
+#ifndef __checkSYM_H_
+#define __checkSYM_H_
+
+int test_checkSYM(void* args, const char* dataDir);
+
+#endif // __checkSYM_H_
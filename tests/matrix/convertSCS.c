@@ -8,10 +8,38 @@
 #include "../../src/matrix.h"
 #include "../common.h"
 
-int test_convertSCS(void* args, const char* dataDir){
+static void dumpSCSMatrixToFile(Matrix* m, FILE* fp){
+	SCSMatrix* sm = &m->scs;
+
+	fprintf(fp, "m->startRow = %lld\n", (long long)m->startRow);
+	fprintf(fp, "m->stopRow = %lld\n", (long long)m->stopRow);
+	fprintf(fp, "m->totalNr = %lld\n", (long long)m->totalNr);
+	fprintf(fp, "m->totalNnz = %lld\n", (long long)m->totalNnz);
+	fprintf(fp, "m->nr = %d\n", m->nr);
+	fprintf(fp, "m->nc = %d\n", m->nc);
+	fprintf(fp, "m->nnz = %d\n", m->nnz);
+	fprintf(fp, "m->C = %d\n", sm->C);
+	fprintf(fp, "m->sigma = %d\n", sm->sigma);
+	fprintf(fp, "m->nChunks = %d\n", sm->nChunks);
+	fprintf(fp, "m->nrPadded = %d\n", sm->nrPadded);
+	fprintf(fp, "m->nElems = %d\n", sm->nElems);
+
+	fprintf(fp, "oldToNewPerm: ");
+	for (int i = 0; i < m->nr; ++i) fprintf(fp, "%d, ", sm->oldToNewPerm[i]);
+	fprintf(fp, "\nnewToOldPerm: ");
+	for (int i = 0; i < m->nr; ++i) fprintf(fp, "%d, ", sm->newToOldPerm[i]);
+	fprintf(fp, "\nchunkLens: ");
+	for (int i = 0; i < sm->nChunks; ++i) fprintf(fp, "%d, ", sm->chunkLens[i]);
+	fprintf(fp, "\nchunkPtr: ");
+	for (int i = 0; i <= sm->nChunks; ++i) fprintf(fp, "%d, ", sm->chunkPtr[i]);
+	fprintf(fp, "\ncolInd: ");
+	for (int i = 0; i < sm->nElems; ++i) fprintf(fp, "%d, ", sm->colInd[i]);
+	fprintf(fp, "\nval: ");
+	for (int i = 0; i < sm->nElems; ++i) fprintf(fp, "%f, ", sm->val[i]);
+	fprintf(fp, "\n");
+}
 
-	int rank = 0;
-	int size = 1;
+int test_convertSCS(void* args, const char* dataDir){
 
 	// Open the directory
 	char *pathToMatrices = malloc(strlen(dataDir) + strlen("testMatrices/") + 1);
@@ -34,8 +62,9 @@ int test_convertSCS(void* args, const char* dataDir){
 
 			Matrix A;
 			Args* arguments = (Args*)args;
-			A.C = arguments->C;
-			A.sigma = arguments->sigma;
+			A.format = FMT_SCS;
+			A.scs.C = arguments->C;
+			A.scs.sigma = arguments->sigma;
 
 			// String preprocessing
 			char C_str[STR_LEN];                           
@@ -49,16 +78,19 @@ int test_convertSCS(void* args, const char* dataDir){
 			// Validate against expected data, if it exists
 			if(fopen(pathToExpectedData, "r")){
 
-				MmMatrix m;
-				matrixRead( &m, pathToMatrix );
+				MMMatrix mm;
+				MMMatrixRead(&mm, pathToMatrix);
 
-				// Set single rank defaults for MmMatrix
-				m.startRow = 0;
-				m.stopRow = m.nr;
-				m.totalNr = m.nr;
-				m.totalNnz = m.nnz;
-			
-				matrixConvertMMtoSCS(&m, &A, rank, size);
+				// Set single rank defaults for MMMatrix
+				mm.startRow = 0;
+				mm.stopRow = mm.nr - 1;
+				mm.totalNr = mm.nr;
+				mm.totalNnz = mm.nnz;
+
+				GMatrix m;
+				matrixConvertfromMM(&mm, &m);
+				m.newToOld = NULL;
+				convertMatrix(&A, &m);
 
 				// Dump to this external file
 				char *pathToReportedData = malloc(STR_LEN);
@@ -67,6 +99,7 @@ int test_convertSCS(void* args, const char* dataDir){
 
 				dumpSCSMatrixToFile(&A, reportedData);
 				fclose(reportedData);
+				matrixFree(&A);
 			
 				// If the expect and reported data differ in some way
 				if(diff_files(pathToExpectedData, pathToReportedData)){
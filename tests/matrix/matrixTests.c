@@ -1,5 +1,6 @@
 
 #include "convertSCS.h"
+#include "checkSYM.h"
 #include "../common.h"
 
 #include <stdio.h>
@@ -25,7 +26,8 @@ int matrixTests(int argc, char** argv){
 	Test tests[] = {
 		{ "convertSell-1-1", test_convertSCS },	// Test 1
 		{ "convertSell-2-1", test_convertSCS },	// Test 2
-		{ "convertSell-4-1", test_convertSCS }	// Test 3
+		{ "convertSell-4-1", test_convertSCS },	// Test 3
+		{ "rejectSYM", test_checkSYM }	// Test 4
 		// Add more here...
 	};
 
@@ -45,6 +47,7 @@ int matrixTests(int argc, char** argv){
 	SET_ARGS(0, 1, 1);	// Test 1
 	SET_ARGS(1, 2, 1);	// Test 2
 	SET_ARGS(2, 4, 1);	// Test 3
+	SET_ARGS(3, 1, 1);	// Test 4
 
 	printf("Running %d Matrix tests:\n", num_tests);
 	for (int i = 0; i < num_tests; ++i) {
@@ -7,7 +7,6 @@
 #include <string.h>
 #include "../../src/matrix.h"
 #include "../../src/solver.h"
-#include "../../src/debugger.h"
 #include "../../src/allocate.h"
 #include "../common.h"
 
@@ -16,10 +15,13 @@
 #include <omp.h>
 #endif
 
+static void dumpVectorToFile(CG_FLOAT* v, int n, FILE* fp){
+	fprintf(fp, "vec = ");
+	for (int i = 0; i < n; ++i) fprintf(fp, "%f, ", v[i]);
+}
+
 int test_spmvSCS(void* args, const char* dataDir){
 
-	int rank = 0;
-	int size = 1;
 	int validFileCount = 0;
 
 	// Open the directory
@@ -44,12 +46,10 @@ int test_spmvSCS(void* args, const char* dataDir){
 
 			Matrix A;
 			Args* arguments = (Args*)args;
-			A.C = arguments->C;
-			A.sigma = arguments->sigma;
 			char C_str[STR_LEN];                           
 			char sigma_str[STR_LEN];
-			sprintf(C_str, "%d", A.C);
-			sprintf(sigma_str, "%d", A.sigma);
+			sprintf(C_str, "%d", arguments->C);
+			sprintf(sigma_str, "%d", arguments->sigma);
 
 			// String preprocessing
 			FORMAT_AND_STRIP_VECTOR_FILE(entry)
@@ -65,30 +65,33 @@ int test_spmvSCS(void* args, const char* dataDir){
 			if(fopen(pathToExpectedData, "r")){
 				++validFileCount;
 
-				MmMatrix m;
-				matrixRead( &m, pathToMatrix );
+				MMMatrix mm;
+				MMMatrixRead(&mm, pathToMatrix);
+
+				// Set single rank defaults for MMMatrix
+				mm.startRow = 0;
+				mm.stopRow = mm.nr - 1;
+				mm.totalNr = mm.nr;
+				mm.totalNnz = mm.nnz;
+
+				GMatrix m;
+				matrixConvertfromMM(&mm, &m);
+				m.newToOld = NULL;
 
-				// Set single rank defaults for MmMatrix
-				m.startRow = 0;
-				m.stopRow = m.nr;
-				m.totalNr = m.nr;
-				m.totalNnz = m.nnz;
-			
 				int vectorSize;
-				char* matrixFormat = (char*)malloc(4*sizeof(char)); 
 
-				if(A.C == 0 || A.sigma == 0){
-					matrixConvertMMtoCRS(&m, &A, rank, size);
+				if(arguments->C == 0 || arguments->sigma == 0){
+					A.format = FMT_CRS;
+					convertMatrix(&A, &m);
 					vectorSize = A.nr;
-					strcpy(matrixFormat, "CRS");
 				}
 				else{
-					matrixConvertMMtoSCS(&m, &A, rank, size);
-					vectorSize = A.nrPadded;
-					strcpy(matrixFormat, "SCS");
+					A.format = FMT_SCS;
+					A.scs.C = arguments->C;
+					A.scs.sigma = arguments->sigma;
+					convertMatrix(&A, &m);
+					vectorSize = A.scs.nrPadded;
 				}
-				VALIDATE_MATRIX_FORMAT(matrixFormat);
-				A.matrixFormat = matrixFormat;
 
 				CG_FLOAT* x = (CG_FLOAT*)allocate(ARRAY_ALIGNMENT, vectorSize * sizeof(CG_FLOAT));
 				CG_FLOAT* y = (CG_FLOAT*)allocate(ARRAY_ALIGNMENT, vectorSize * sizeof(CG_FLOAT));
@@ -110,6 +113,9 @@ int test_spmvSCS(void* args, const char* dataDir){
 				
 				dumpVectorToFile(y, A.nr, reportedData);
 				fclose(reportedData);
+				matrixFree(&A);
+				free(x);
+				free(y);
 			
 				// If the expect and reported data differ in some way
 				if(diff_files(pathToExpectedData, pathToReportedData)){